@@ -0,0 +1,52 @@
+#pragma once
+
+// The classes of the backend that is built in, for the code that calls into the platform every frame.
+//
+// With BZF_STATIC_DISPATCH defined these are the concrete backend classes. Those are final, so calls made through these
+// types are resolved at compile time and can be inlined. Otherwise they are just the interfaces, which keeps that code
+// working with any BzfPlatform, like in tools that do not know which backend they run on.
+
+#include "BzfPlatform.h"
+
+#include <assert.h>
+
+#ifdef BZF_STATIC_DISPATCH
+#ifdef USE_GLFW
+#include "GLFWPlatform.h"
+
+typedef GLFWPlatform BzfBackendPlatform;
+typedef GLFWWindow BzfBackendWindow;
+typedef GLFWJoystick BzfBackendJoystick;
+#else
+#include "SDL2Platform.h"
+
+typedef SDL2Platform BzfBackendPlatform;
+typedef SDL2Window BzfBackendWindow;
+typedef SDL2Joystick BzfBackendJoystick;
+#endif
+#else
+typedef BzfPlatform BzfBackendPlatform;
+typedef BzfWindow BzfBackendWindow;
+typedef BzfJoystick BzfBackendJoystick;
+#endif
+
+// Only one window system backend is built in, so everything the interfaces point to is of the backend types, except
+// for the objects of the null platform (NullPlatform.h), which is always built in as well. Those must never be passed
+// here, which debug builds check. nullptr passes through.
+inline BzfBackendPlatform* bzfBackend(BzfPlatform* platform)
+{
+    assert(platform == nullptr || dynamic_cast<BzfBackendPlatform*>(platform) != nullptr);
+    return static_cast<BzfBackendPlatform*>(platform);
+}
+
+inline BzfBackendWindow* bzfBackend(BzfWindow* window)
+{
+    assert(window == nullptr || dynamic_cast<BzfBackendWindow*>(window) != nullptr);
+    return static_cast<BzfBackendWindow*>(window);
+}
+
+inline BzfBackendJoystick* bzfBackend(BzfJoystick* joystick)
+{
+    assert(joystick == nullptr || dynamic_cast<BzfBackendJoystick*>(joystick) != nullptr);
+    return static_cast<BzfBackendJoystick*>(joystick);
+}
@@ -0,0 +1,58 @@
+#include "BzfClock.h"
+
+#if defined(_WIN32)
+#  include <windows.h>
+#elif defined(__APPLE__)
+#  include <mach/mach_time.h>
+#else
+#  include <time.h>
+#endif
+
+#if defined(_WIN32)
+
+static uint64_t counterFrequency()
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return frequency.QuadPart;
+}
+
+uint64_t BzfClock::now()
+{
+    static const uint64_t frequency = counterFrequency();
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // Convert whole seconds and the remainder separately, as the counter times 10^9 would overflow after a few hours
+    uint64_t ticks = counter.QuadPart;
+    return (ticks / frequency) * ticksPerSecond + (ticks % frequency) * ticksPerSecond / frequency;
+}
+
+#elif defined(__APPLE__)
+
+static mach_timebase_info_data_t machTimebase()
+{
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    return timebase;
+}
+
+uint64_t BzfClock::now()
+{
+    static const mach_timebase_info_data_t timebase = machTimebase();
+    uint64_t ticks = mach_absolute_time();
+    // The timebase is 1/1 on Intel, so this is usually free
+    if (timebase.numer == timebase.denom)
+        return ticks;
+    return (ticks / timebase.denom) * timebase.numer + (ticks % timebase.denom) * timebase.numer / timebase.denom;
+}
+
+#else
+
+uint64_t BzfClock::now()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * ticksPerSecond + time.tv_nsec;
+}
+
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+// A monotonic clock counting integer nanoseconds from an arbitrary point. It reads the OS high resolution counter
+// directly (clock_gettime, which goes through the vDSO on Linux and does not enter the kernel, QueryPerformanceCounter
+// on Windows and mach_absolute_time on macOS), so it is cheap enough to time individual events and profile zones.
+// Unlike a double of seconds, the resolution does not degrade the longer the program runs.
+class BzfClock
+{
+public:
+    static const uint64_t ticksPerSecond = 1000000000ull;
+
+    static uint64_t now();
+
+    static double toSeconds(int64_t ticks)
+    {
+        return (double)ticks / ticksPerSecond;
+    }
+    static double toMilliseconds(int64_t ticks)
+    {
+        return (double)ticks / (ticksPerSecond / 1000);
+    }
+    static int64_t fromSeconds(double seconds)
+    {
+        return (int64_t)(seconds * ticksPerSecond);
+    }
+};
@@ -0,0 +1,208 @@
+#include "BzfFramePacer.h"
+#include "BzfPlatform.h"
+#include "BzfProfiler.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// How much a sleep counts towards the estimate, which makes it mostly follow the last few dozen sleeps
+static const double sleepWeight = 0.05;
+
+BzfFramePacer::BzfFramePacer(BzfPlatform *_platform, bool _pollEvents) : platform(_platform), pollEvents(_pollEvents),
+    latePolling(false), eventWaiting(false), frameInterval(0), nextFrame(0), lastFrameStart(0),
+    sleepEstimate(BzfClock::fromSeconds(0.001)), sleepMean(0.0), sleepVariance(0.0), sleepCount(0)
+{
+    // Until the first sleep was measured, assume that it takes no longer than asked for. Anything higher could keep a
+    // pacer from ever sleeping, and so from measuring, and sleeping here would cost every pacer that is made.
+    resetStatistics();
+}
+
+void BzfFramePacer::setTargetFrameRate(double framesPerSecond)
+{
+    frameInterval = framesPerSecond > 0.0 ? BzfClock::fromSeconds(1.0 / framesPerSecond) : 0;
+    // Start over from the next frame rather than catching up on the old schedule
+    nextFrame = 0;
+}
+
+double BzfFramePacer::getTargetFrameRate() const
+{
+    return frameInterval > 0 ? 1.0 / BzfClock::toSeconds(frameInterval) : 0.0;
+}
+
+void BzfFramePacer::setLateInputPolling(bool late)
+{
+    latePolling = late;
+}
+
+bool BzfFramePacer::isLateInputPolling() const
+{
+    return latePolling;
+}
+
+void BzfFramePacer::setEventWaiting(bool wait)
+{
+    eventWaiting = wait;
+}
+
+bool BzfFramePacer::isEventWaiting() const
+{
+    return eventWaiting;
+}
+
+void BzfFramePacer::beginFrame()
+{
+    // Nothing is on screen, so sleep until something happens rather than drawing frames that nobody sees
+    if (pollEvents && platform->isIdle())
+    {
+        platform->waitEvents(platform->getIdleInterval());
+        platform->runMainThreadJobs();
+        // Start on a fresh schedule once drawing resumes, and keep the idle time out of the frame times
+        nextFrame = 0;
+        lastFrameStart = 0;
+        return;
+    }
+
+    // Waiting for the events handles them as well
+    bool waitingForEvents = pollEvents && eventWaiting && frameInterval > 0;
+    if (waitingForEvents)
+        waitForEvents();
+
+    if (pollEvents && !latePolling && !waitingForEvents)
+    {
+        platform->pollEvents();
+        platform->runMainThreadJobs();
+    }
+
+    if (frameInterval > 0 && !waitingForEvents)
+    {
+        uint64_t now = platform->getGameTicks();
+        // Fell behind by more than a frame (or this is the first one), so do not try to make up for it
+        if (nextFrame == 0 || (now > nextFrame && now - nextFrame > frameInterval))
+            nextFrame = now;
+        else
+            waitUntil(nextFrame);
+        nextFrame += frameInterval;
+    }
+
+    if (pollEvents && latePolling && !waitingForEvents)
+    {
+        platform->pollEvents();
+        platform->runMainThreadJobs();
+    }
+
+    uint64_t now = platform->getGameTicks();
+    if (lastFrameStart != 0)
+        addFrameTime(BzfClock::toSeconds(now - lastFrameStart));
+    lastFrameStart = now;
+}
+
+unsigned long BzfFramePacer::getFrameCount() const
+{
+    return frameCount;
+}
+
+double BzfFramePacer::getFrameTimeMean() const
+{
+    return frameTimeMean;
+}
+
+double BzfFramePacer::getFrameTimeVariance() const
+{
+    return frameCount > 1 ? frameTimeM2 / (frameCount - 1) : 0.0;
+}
+
+double BzfFramePacer::getFrameTimeStdDev() const
+{
+    return sqrt(getFrameTimeVariance());
+}
+
+double BzfFramePacer::getFrameTimeMin() const
+{
+    return frameCount > 0 ? frameTimeMin : 0.0;
+}
+
+double BzfFramePacer::getFrameTimeMax() const
+{
+    return frameTimeMax;
+}
+
+void BzfFramePacer::resetStatistics()
+{
+    frameCount = 0;
+    frameTimeMean = 0.0;
+    frameTimeM2 = 0.0;
+    frameTimeMin = 0.0;
+    frameTimeMax = 0.0;
+}
+
+void BzfFramePacer::waitUntil(uint64_t deadline)
+{
+    BZF_PROFILE_ZONE("BzfFramePacer::wait");
+    uint64_t now = platform->getGameTicks();
+
+    // Sleep in small steps while the remaining time is safely above what a sleep might take
+    while (now < deadline && deadline - now > sleepEstimate)
+    {
+        measureSleep();
+        now = platform->getGameTicks();
+    }
+
+    // Spin for the rest
+    while (now < deadline)
+    {
+        std::this_thread::yield();
+        now = platform->getGameTicks();
+    }
+}
+
+void BzfFramePacer::waitForEvents()
+{
+    uint64_t now = platform->getGameTicks();
+    // Fell behind by more than a frame (or this is the first one), so do not try to make up for it
+    if (nextFrame == 0 || (now > nextFrame && now - nextFrame > frameInterval))
+        nextFrame = now;
+
+    if (now < nextFrame)
+    {
+        BZF_PROFILE_ZONE("BzfFramePacer::waitEvents");
+        platform->waitEvents(BzfClock::toSeconds(nextFrame - now));
+    }
+    else
+        platform->pollEvents();
+    platform->runMainThreadJobs();
+
+    // The deadline only moves on once it was reached, so that a wait cut short by an event is continued next frame
+    if (platform->getGameTicks() >= nextFrame)
+        nextFrame += frameInterval;
+}
+
+void BzfFramePacer::measureSleep()
+{
+    uint64_t start = BzfClock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    double observed = BzfClock::toSeconds(BzfClock::now() - start);
+
+    if (sleepCount++ == 0)
+        sleepMean = observed;
+    else
+    {
+        double delta = observed - sleepMean;
+        sleepMean += sleepWeight * delta;
+        sleepVariance = (1.0 - sleepWeight) * (sleepVariance + sleepWeight * delta * delta);
+    }
+    sleepEstimate = BzfClock::fromSeconds(sleepMean + sqrt(sleepVariance));
+}
+
+void BzfFramePacer::addFrameTime(double frameTime)
+{
+    ++frameCount;
+    double delta = frameTime - frameTimeMean;
+    frameTimeMean += delta / frameCount;
+    frameTimeM2 += delta * (frameTime - frameTimeMean);
+
+    if (frameCount == 1 || frameTime < frameTimeMin)
+        frameTimeMin = frameTime;
+    if (frameTime > frameTimeMax)
+        frameTimeMax = frameTime;
+}
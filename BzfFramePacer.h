@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+
+class BzfPlatform;
+
+// Holds a loop to a target frame rate on the platform's game tick clock. Waiting sleeps while there is plenty of time
+// left and spins for the last stretch, because sleeps routinely overshoot by a millisecond or more. How far a sleep
+// overshoots is measured as we go, starting with the first wait, so the spin only covers what the scheduler can not be
+// trusted with. The estimate favours recent sleeps, so that it follows changes in load and power state.
+//
+// The pacer of the platform (BzfPlatform::getFramePacer()) also polls the events. With late input polling, that
+// happens after the wait instead of before it, so the frame gets drawn with input that is as fresh as possible. Right
+// after the events, it runs the main-thread jobs of the platform's job system.
+class BzfFramePacer
+{
+public:
+    // A pacer with pollEvents set calls platform->pollEvents() and platform->runMainThreadJobs() once per frame. That
+    // must only be done on the main thread, so pacers for render threads are created without it.
+    BzfFramePacer(BzfPlatform *platform, bool pollEvents = false);
+
+    // Frames per second to aim for, 0 to not limit the frame rate at all
+    void setTargetFrameRate(double framesPerSecond);
+    double getTargetFrameRate() const;
+    void setLateInputPolling(bool late);
+    bool isLateInputPolling() const;
+    // A pacer that polls the events can block in waitEvents() until the frame is due, instead of sleeping and spinning.
+    // It then returns early whenever events arrive, which suits loops that only handle events, like the main thread
+    // while render threads do the drawing.
+    void setEventWaiting(bool wait);
+    bool isEventWaiting() const;
+
+    // Call once per frame before drawing. Waits until the frame is due, and polls the events if this pacer does that.
+    // A pacer that polls the events waits for them instead while the platform is idle, see BzfPlatform::isIdle().
+    void beginFrame();
+
+    // Time between the starts of consecutive frames, in seconds
+    unsigned long getFrameCount() const;
+    double getFrameTimeMean() const;
+    double getFrameTimeVariance() const;
+    double getFrameTimeStdDev() const;
+    double getFrameTimeMin() const;
+    double getFrameTimeMax() const;
+    void resetStatistics();
+
+private:
+    void waitUntil(uint64_t deadline);
+    // Handle the events until the frame is due or some arrive
+    void waitForEvents();
+    // Sleep for 1 ms and add how long that took to the estimate
+    void measureSleep();
+    void addFrameTime(double frameTime);
+
+    BzfPlatform *platform;
+    bool pollEvents;
+    bool latePolling;
+    bool eventWaiting;
+    // In game ticks, 0 when not limiting the frame rate
+    uint64_t frameInterval;
+    // When the next frame is due, 0 until the first frame started
+    uint64_t nextFrame;
+    uint64_t lastFrameStart;
+
+    // Running estimate (in game ticks) of how long a 1 ms sleep really takes, from the exponentially weighted mean and
+    // variance of past sleeps
+    uint64_t sleepEstimate;
+    double sleepMean;
+    double sleepVariance;
+    unsigned long sleepCount;
+
+    // Frame time statistics, with the variance accumulated using Welford's method
+    unsigned long frameCount;
+    double frameTimeMean;
+    double frameTimeM2;
+    double frameTimeMin;
+    double frameTimeMax;
+};
@@ -0,0 +1,96 @@
+#include "BzfFramesInFlight.h"
+#include "BzfClock.h"
+#include "BzfMetrics.h"
+
+#include "BzfGL.h"
+
+// How long to wait for the GPU before giving up on a frame, in nanoseconds
+static const GLuint64 fenceTimeout = 100000000;
+
+BzfFramesInFlight::BzfFramesInFlight() : limit(0), first(0), count(0)
+{
+    resetStatistics();
+}
+
+void BzfFramesInFlight::setLimit(int _limit)
+{
+    if (_limit <= 0)
+    {
+        limit = 0;
+        clear();
+    }
+    else
+        limit = (_limit > maxLimit) ? maxLimit : _limit;
+}
+
+int BzfFramesInFlight::getLimit() const
+{
+    return limit;
+}
+
+void BzfFramesInFlight::frameSwapped(bool sync)
+{
+    static BzfHistogram *gpuWaits = BzfMetrics::get().histogram("gpu.wait.ms", BzfMetrics::millisecondBounds());
+
+    if (limit == 0)
+        return;
+
+    uint64_t start = BzfClock::now();
+    if (sync)
+    {
+        fences[(first + count) % (maxLimit + 1)] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ++count;
+
+        // A limit that was just lowered can take more than one wait
+        while (count > limit)
+        {
+            GLsync fence = static_cast<GLsync>(fences[first]);
+            // A fence that times out is dropped all the same, so that a hung frame can not stall the loop forever
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, fenceTimeout);
+            glDeleteSync(fence);
+            first = (first + 1) % (maxLimit + 1);
+            --count;
+        }
+    }
+    // Without sync objects glFinish() is the only way to keep a bound, and it is even stricter than a limit of 1
+    else if (limit == 1)
+        glFinish();
+
+    uint64_t waited = BzfClock::now() - start;
+    ++frames;
+    waitTicks += waited;
+    if (waited > maxWaitTicks)
+        maxWaitTicks = waited;
+    gpuWaits->observe(BzfClock::toMilliseconds(waited));
+}
+
+unsigned long BzfFramesInFlight::getFrameCount() const
+{
+    return frames;
+}
+
+double BzfFramesInFlight::getWaitMean() const
+{
+    return frames > 0 ? BzfClock::toSeconds(waitTicks) / frames : 0.0;
+}
+
+double BzfFramesInFlight::getWaitMax() const
+{
+    return BzfClock::toSeconds(maxWaitTicks);
+}
+
+void BzfFramesInFlight::resetStatistics()
+{
+    frames = 0;
+    waitTicks = 0;
+    maxWaitTicks = 0;
+}
+
+void BzfFramesInFlight::clear()
+{
+    // There are only fences when the context has sync objects
+    for (int i = 0; i < count; ++i)
+        glDeleteSync(static_cast<GLsync>(fences[(first + i) % (maxLimit + 1)]));
+    first = 0;
+    count = 0;
+}
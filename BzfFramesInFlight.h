@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+// Bounds how many frames of a window the GPU can be behind the CPU. Drivers are free to queue up several swapped frames
+// before they block, which adds a frame of latency for each. After every swap this waits on a fence from an earlier
+// frame until at most the limit of frames is still unfinished. A limit of 1 gives the lowest latency (the CPU works on
+// the next frame while the GPU draws the last one), 2 keeps both busy for the best throughput.
+class BzfFramesInFlight
+{
+public:
+    static const int maxLimit = 3;
+
+    BzfFramesInFlight();
+
+    // 0 turns the limit off, anything else is clamped to 1 to maxLimit. Call on the thread that renders the window,
+    // with its context current.
+    void setLimit(int limit);
+    int getLimit() const;
+
+    // Called by the backends right after the swap, with the context of the window current. sync tells whether the
+    // context has fences, see BzfGLCapabilities.
+    void frameSwapped(bool sync);
+
+    // How long frameSwapped() waited for the GPU, over the frames since the statistics were reset, in seconds
+    unsigned long getFrameCount() const;
+    double getWaitMean() const;
+    double getWaitMax() const;
+    void resetStatistics();
+
+private:
+    void clear();
+
+    int limit;
+    // Fences of the frames the GPU may still be working on, oldest first. These are GLsync handles, which are kept as
+    // plain pointers so that the platform headers do not need the OpenGL ones.
+    void *fences[maxLimit + 1];
+    int first;
+    int count;
+
+    unsigned long frames;
+    uint64_t waitTicks;
+    uint64_t maxWaitTicks;
+};
@@ -0,0 +1,136 @@
+#include "BzfGL.h"
+
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+#define BZF_GL_DEFINE(type, name, parameters) type (GLAPIENTRY *bzf_gl##name) parameters = nullptr;
+BZF_GL_FUNCTIONS(BZF_GL_DEFINE)
+BZF_GL_OPTIONAL_FUNCTIONS(BZF_GL_DEFINE)
+#undef BZF_GL_DEFINE
+
+// Guards the function pointers while a context loads them
+static std::mutex loadMutex;
+
+static bool versionAtLeast(const BzfGLCapabilities &capabilities, int major, int minor)
+{
+    return capabilities.majorVersion > major ||
+           (capabilities.majorVersion == major && capabilities.minorVersion >= minor);
+}
+
+// Look a function up unless an earlier context already did. Once set, a pointer is never changed again, as render
+// threads may be calling through it.
+template<class Function> static bool resolve(Function &function, BzfGLGetProcAddress getProcAddress, const char *name)
+{
+    if (function == nullptr)
+        function = (Function)getProcAddress(name);
+    return function != nullptr;
+}
+
+bool hasGLExtension(const BzfGLCapabilities &capabilities, const char *name)
+{
+    if (versionAtLeast(capabilities, 3, 0) && glGetStringi != nullptr)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            const char *extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (extension != nullptr && strcmp(extension, name) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    // Before 3.0 they are one string separated by spaces, and one name can be the start of another
+    const char *extensions = (const char*)glGetString(GL_EXTENSIONS);
+    if (extensions == nullptr)
+        return false;
+    size_t length = strlen(name);
+    for (const char *found = strstr(extensions, name); found != nullptr; found = strstr(found + length, name))
+    {
+        if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+            return true;
+    }
+    return false;
+}
+
+bool loadGLFunctions(BzfGLGetProcAddress getProcAddress, BzfGLCapabilities &capabilities)
+{
+    std::lock_guard<std::mutex> lock(loadMutex);
+    capabilities = BzfGLCapabilities();
+
+    bool missing = false;
+#define BZF_GL_LOAD(type, name, parameters) \
+    if (!resolve(bzf_gl##name, getProcAddress, "gl" #name)) \
+    { \
+        fprintf(stderr, "OpenGL function gl%s not found\n", #name); \
+        missing = true; \
+    }
+    BZF_GL_FUNCTIONS(BZF_GL_LOAD)
+#undef BZF_GL_LOAD
+    if (missing)
+        return false;
+
+    // "OpenGL ES 3.2 Mesa 20.0.8" or "4.6.0 NVIDIA 450.80.02"
+    const char *version = (const char*)glGetString(GL_VERSION);
+    if (version == nullptr)
+    {
+        fprintf(stderr, "OpenGL version not available, is the context current?\n");
+        return false;
+    }
+    const char *esPrefix = "OpenGL ES";
+    capabilities.es = strncmp(version, esPrefix, strlen(esPrefix)) == 0;
+    if (capabilities.es)
+    {
+        version += strlen(esPrefix);
+        // "OpenGL ES-CM 1.1" and the like
+        while (*version != '\0' && *version != ' ')
+            version++;
+    }
+    if (sscanf(version, "%d.%d", &capabilities.majorVersion, &capabilities.minorVersion) != 2)
+    {
+        fprintf(stderr, "OpenGL version \"%s\" not understood\n", version);
+        return false;
+    }
+
+    // Some drivers hand out addresses for anything that starts with "gl", so the optional functions are only looked up
+    // for a context whose version or extensions say it has them. Whether a context may call one is in its
+    // capabilities, as the pointer can have been found for another context.
+    if (versionAtLeast(capabilities, 3, 0))
+        resolve(glGetStringi, getProcAddress, "glGetStringi");
+
+    if (capabilities.es)
+        capabilities.sync = versionAtLeast(capabilities, 3, 0);
+    else
+        capabilities.sync = versionAtLeast(capabilities, 3, 2) || hasGLExtension(capabilities, "GL_ARB_sync");
+    capabilities.sync = capabilities.sync && resolve(glFenceSync, getProcAddress, "glFenceSync") &&
+                        resolve(glClientWaitSync, getProcAddress, "glClientWaitSync") &&
+                        resolve(glDeleteSync, getProcAddress, "glDeleteSync");
+
+    if (versionAtLeast(capabilities, capabilities.es ? 3 : 4, capabilities.es ? 2 : 3))
+        capabilities.debugOutput = resolve(glDebugMessageCallback, getProcAddress, "glDebugMessageCallback");
+    else if (hasGLExtension(capabilities, "GL_KHR_debug"))
+    {
+        // OpenGL ES only has the extension's functions with a suffix
+        capabilities.debugOutput = resolve(glDebugMessageCallback, getProcAddress,
+                                           capabilities.es ? "glDebugMessageCallbackKHR" : "glDebugMessageCallback");
+    }
+
+    capabilities.releaseShaderCompiler = (capabilities.es || versionAtLeast(capabilities, 4, 1) ||
+                                          hasGLExtension(capabilities, "GL_ARB_ES2_compatibility")) &&
+                                         resolve(glReleaseShaderCompiler, getProcAddress, "glReleaseShaderCompiler");
+
+    // The flags can be queried since OpenGL 3.0 and ES 3.2
+    if (versionAtLeast(capabilities, 3, capabilities.es ? 2 : 0))
+    {
+        GLint flags = 0;
+        glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+        capabilities.debugContext = (flags & GL_CONTEXT_FLAG_DEBUG_BIT) != 0;
+        capabilities.noErrorContext = (flags & GL_CONTEXT_FLAG_NO_ERROR_BIT) != 0;
+        capabilities.robustContext = (flags & GL_CONTEXT_FLAG_ROBUST_ACCESS_BIT) != 0;
+    }
+
+    capabilities.loaded = true;
+    return true;
+}
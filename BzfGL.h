@@ -0,0 +1,269 @@
+#pragma once
+
+// The OpenGL types, constants and functions that we use, loaded through the platform instead of linked. Only what is
+// listed here is available, so a function or constant that is needed has to be added to the lists first.
+//
+// The functions are the same for every context of a process on the platforms we support, so they are kept in globals.
+// Each is looked up by the first context that has it and never changed after that, since render threads call through
+// them while other contexts are created. Creating a context finds out what it supports, and the optional functions
+// must only be called where its BzfGLCapabilities say so: a pointer that is set may have been found for another one.
+
+#if defined(__gl_h_) || defined(__GL_H__) || defined(__gl_gl_h_) || defined(__glew_h__) || defined(__gl2_h_)
+#error "BzfGL.h has to be included before any other OpenGL header"
+#endif
+
+// Keep the system headers from being pulled in later, as they would declare the same names
+#define __gl_h_
+#define __GL_H__
+#define __gl_gl_h_
+#define __glext_h_
+#define __gl_glext_h_
+#define __gl2_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#define GLAPIENTRY __stdcall
+#else
+#define GLAPIENTRY
+#endif
+
+typedef unsigned int GLenum;
+typedef unsigned char GLboolean;
+typedef unsigned int GLbitfield;
+typedef void GLvoid;
+typedef int GLint;
+typedef unsigned int GLuint;
+typedef int GLsizei;
+typedef float GLfloat;
+typedef char GLchar;
+typedef unsigned char GLubyte;
+typedef uint64_t GLuint64;
+typedef struct __GLsync *GLsync;
+typedef void (GLAPIENTRY *GLDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                       const GLchar *message, const void *userParam);
+
+#define GL_FALSE 0
+#define GL_TRUE 1
+#define GL_NO_ERROR 0
+
+#define GL_COLOR_BUFFER_BIT 0x00004000
+#define GL_TRIANGLES 0x0004
+#define GL_TRIANGLE_STRIP 0x0005
+#define GL_SRC_ALPHA 0x0302
+#define GL_ONE_MINUS_SRC_ALPHA 0x0303
+#define GL_BLEND 0x0BE2
+#define GL_PACK_ALIGNMENT 0x0D05
+#define GL_TEXTURE_2D 0x0DE1
+#define GL_UNSIGNED_BYTE 0x1401
+#define GL_FLOAT 0x1406
+#define GL_RGBA 0x1908
+#define GL_VENDOR 0x1F00
+#define GL_RENDERER 0x1F01
+#define GL_VERSION 0x1F02
+#define GL_EXTENSIONS 0x1F03
+#define GL_LINEAR 0x2601
+#define GL_TEXTURE_MAG_FILTER 0x2800
+#define GL_TEXTURE_MIN_FILTER 0x2801
+#define GL_TEXTURE_WRAP_S 0x2802
+#define GL_TEXTURE_WRAP_T 0x2803
+#define GL_CLAMP_TO_EDGE 0x812F
+#define GL_TEXTURE0 0x84C0
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_INFO_LOG_LENGTH 0x8B84
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_FRAMEBUFFER 0x8D40
+
+// OpenGL 3.0 and ES 3.0
+#define GL_NUM_EXTENSIONS 0x821D
+#define GL_CONTEXT_FLAGS 0x821E
+#define GL_CONTEXT_FLAG_DEBUG_BIT 0x00000002
+#define GL_CONTEXT_FLAG_ROBUST_ACCESS_BIT 0x00000004
+#define GL_CONTEXT_FLAG_NO_ERROR_BIT 0x00000008
+
+// Sync objects (OpenGL 3.2, ES 3.0 and GL_ARB_sync)
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_CONDITION_SATISFIED 0x911C
+#define GL_WAIT_FAILED 0x911D
+
+// Debug output (OpenGL 4.3, ES 3.2 and GL_KHR_debug)
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+#define GL_DEBUG_TYPE_PORTABILITY 0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#define GL_DEBUG_TYPE_OTHER 0x8251
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#define GL_DEBUG_OUTPUT 0x92E0
+
+// Functions that every context we can draw with has, as return type, name without the gl prefix and parameters
+#define BZF_GL_FUNCTIONS(F) \
+    F(void, ActiveTexture, (GLenum texture)) \
+    F(void, AttachShader, (GLuint program, GLuint shader)) \
+    F(void, BindBuffer, (GLenum target, GLuint buffer)) \
+    F(void, BindFramebuffer, (GLenum target, GLuint framebuffer)) \
+    F(void, BindTexture, (GLenum target, GLuint texture)) \
+    F(void, BlendFunc, (GLenum sfactor, GLenum dfactor)) \
+    F(GLenum, CheckFramebufferStatus, (GLenum target)) \
+    F(void, Clear, (GLbitfield mask)) \
+    F(void, ClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)) \
+    F(void, CompileShader, (GLuint shader)) \
+    F(GLuint, CreateProgram, (void)) \
+    F(GLuint, CreateShader, (GLenum type)) \
+    F(void, DeleteFramebuffers, (GLsizei n, const GLuint *framebuffers)) \
+    F(void, DeleteProgram, (GLuint program)) \
+    F(void, DeleteShader, (GLuint shader)) \
+    F(void, DeleteTextures, (GLsizei n, const GLuint *textures)) \
+    F(void, Disable, (GLenum cap)) \
+    F(void, DisableVertexAttribArray, (GLuint index)) \
+    F(void, DrawArrays, (GLenum mode, GLint first, GLsizei count)) \
+    F(void, Enable, (GLenum cap)) \
+    F(void, EnableVertexAttribArray, (GLuint index)) \
+    F(void, Finish, (void)) \
+    F(void, Flush, (void)) \
+    F(void, FramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)) \
+    F(void, GenFramebuffers, (GLsizei n, GLuint *framebuffers)) \
+    F(void, GenTextures, (GLsizei n, GLuint *textures)) \
+    F(GLint, GetAttribLocation, (GLuint program, const GLchar *name)) \
+    F(GLenum, GetError, (void)) \
+    F(void, GetIntegerv, (GLenum pname, GLint *data)) \
+    F(void, GetProgramiv, (GLuint program, GLenum pname, GLint *params)) \
+    F(void, GetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog)) \
+    F(void, GetShaderiv, (GLuint shader, GLenum pname, GLint *params)) \
+    F(const GLubyte*, GetString, (GLenum name)) \
+    F(GLint, GetUniformLocation, (GLuint program, const GLchar *name)) \
+    F(void, LinkProgram, (GLuint program)) \
+    F(void, PixelStorei, (GLenum pname, GLint param)) \
+    F(void, ReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels)) \
+    F(void, ShaderSource, (GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length)) \
+    F(void, TexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, \
+                         GLenum format, GLenum type, const void *pixels)) \
+    F(void, TexParameteri, (GLenum target, GLenum pname, GLint param)) \
+    F(void, Uniform1f, (GLint location, GLfloat v0)) \
+    F(void, Uniform1i, (GLint location, GLint v0)) \
+    F(void, Uniform2f, (GLint location, GLfloat v0, GLfloat v1)) \
+    F(void, Uniform3f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2)) \
+    F(void, Uniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)) \
+    F(void, Uniform4fv, (GLint location, GLsizei count, const GLfloat *value)) \
+    F(void, UseProgram, (GLuint program)) \
+    F(void, ValidateProgram, (GLuint program)) \
+    F(void, VertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, \
+                                  const void *pointer)) \
+    F(void, Viewport, (GLint x, GLint y, GLsizei width, GLsizei height))
+
+// Functions that only some contexts have. These are null when the context does not support them, see
+// BzfGLCapabilities.
+#define BZF_GL_OPTIONAL_FUNCTIONS(F) \
+    F(GLenum, ClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout)) \
+    F(void, DebugMessageCallback, (GLDEBUGPROC callback, const void *userParam)) \
+    F(void, DeleteSync, (GLsync sync)) \
+    F(GLsync, FenceSync, (GLenum condition, GLbitfield flags)) \
+    F(const GLubyte*, GetStringi, (GLenum name, GLuint index)) \
+    F(void, ReleaseShaderCompiler, (void))
+
+#define BZF_GL_DECLARE(type, name, parameters) extern type (GLAPIENTRY *bzf_gl##name) parameters;
+BZF_GL_FUNCTIONS(BZF_GL_DECLARE)
+BZF_GL_OPTIONAL_FUNCTIONS(BZF_GL_DECLARE)
+#undef BZF_GL_DECLARE
+
+#define glActiveTexture bzf_glActiveTexture
+#define glAttachShader bzf_glAttachShader
+#define glBindBuffer bzf_glBindBuffer
+#define glBindFramebuffer bzf_glBindFramebuffer
+#define glBindTexture bzf_glBindTexture
+#define glBlendFunc bzf_glBlendFunc
+#define glCheckFramebufferStatus bzf_glCheckFramebufferStatus
+#define glClear bzf_glClear
+#define glClearColor bzf_glClearColor
+#define glCompileShader bzf_glCompileShader
+#define glCreateProgram bzf_glCreateProgram
+#define glCreateShader bzf_glCreateShader
+#define glDeleteFramebuffers bzf_glDeleteFramebuffers
+#define glDeleteProgram bzf_glDeleteProgram
+#define glDeleteShader bzf_glDeleteShader
+#define glDeleteTextures bzf_glDeleteTextures
+#define glDisable bzf_glDisable
+#define glDisableVertexAttribArray bzf_glDisableVertexAttribArray
+#define glDrawArrays bzf_glDrawArrays
+#define glEnable bzf_glEnable
+#define glEnableVertexAttribArray bzf_glEnableVertexAttribArray
+#define glFinish bzf_glFinish
+#define glFlush bzf_glFlush
+#define glFramebufferTexture2D bzf_glFramebufferTexture2D
+#define glGenFramebuffers bzf_glGenFramebuffers
+#define glGenTextures bzf_glGenTextures
+#define glGetAttribLocation bzf_glGetAttribLocation
+#define glGetError bzf_glGetError
+#define glGetIntegerv bzf_glGetIntegerv
+#define glGetProgramiv bzf_glGetProgramiv
+#define glGetShaderInfoLog bzf_glGetShaderInfoLog
+#define glGetShaderiv bzf_glGetShaderiv
+#define glGetString bzf_glGetString
+#define glGetUniformLocation bzf_glGetUniformLocation
+#define glLinkProgram bzf_glLinkProgram
+#define glPixelStorei bzf_glPixelStorei
+#define glReadPixels bzf_glReadPixels
+#define glShaderSource bzf_glShaderSource
+#define glTexImage2D bzf_glTexImage2D
+#define glTexParameteri bzf_glTexParameteri
+#define glUniform1f bzf_glUniform1f
+#define glUniform1i bzf_glUniform1i
+#define glUniform2f bzf_glUniform2f
+#define glUniform3f bzf_glUniform3f
+#define glUniform4f bzf_glUniform4f
+#define glUniform4fv bzf_glUniform4fv
+#define glUseProgram bzf_glUseProgram
+#define glValidateProgram bzf_glValidateProgram
+#define glVertexAttribPointer bzf_glVertexAttribPointer
+#define glViewport bzf_glViewport
+
+#define glClientWaitSync bzf_glClientWaitSync
+#define glDebugMessageCallback bzf_glDebugMessageCallback
+#define glDeleteSync bzf_glDeleteSync
+#define glFenceSync bzf_glFenceSync
+#define glGetStringi bzf_glGetStringi
+#define glReleaseShaderCompiler bzf_glReleaseShaderCompiler
+
+// What a context supports, as found by loadGLFunctions()
+struct BzfGLCapabilities
+{
+    // Whether all the functions that are not optional were found
+    bool loaded;
+    // OpenGL ES rather than desktop OpenGL
+    bool es;
+    int majorVersion;
+    int minorVersion;
+    // Fences, through glFenceSync(), glClientWaitSync() and glDeleteSync()
+    bool sync;
+    // glDebugMessageCallback()
+    bool debugOutput;
+    // glReleaseShaderCompiler(), which desktop OpenGL only has since 4.1
+    bool releaseShaderCompiler;
+    // How the context was created, where the version is recent enough to ask
+    bool debugContext;
+    bool noErrorContext;
+    bool robustContext;
+};
+
+// Takes a function name and returns its address, or nullptr, like SDL_GL_GetProcAddress()
+typedef void* (*BzfGLGetProcAddress)(const char *name);
+
+// Load the functions of the context that is current on the calling thread and find out what it supports. Returns false
+// (after reporting what is missing) if a function that is not optional could not be found.
+bool loadGLFunctions(BzfGLGetProcAddress getProcAddress, BzfGLCapabilities &capabilities);
+// Whether the current context, which loadGLFunctions() found the capabilities of, has an extension
+bool hasGLExtension(const BzfGLCapabilities &capabilities, const char *name);
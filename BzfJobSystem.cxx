@@ -0,0 +1,307 @@
+#include "BzfJobSystem.h"
+#include "BzfMetrics.h"
+#include "BzfProfiler.h"
+
+#include <chrono>
+
+struct BzfJob
+{
+    std::function<void()> work;
+    bool mainThread;
+    // Dependencies that did not finish yet, plus one that submitting holds until all of them are accounted for
+    std::atomic<int> waitingFor;
+    std::atomic<bool> finished;
+    // Guards dependents, and finishing, so that a job is either added as a dependent or sees that this one finished
+    std::mutex mutex;
+    std::vector<BzfJobHandle> dependents;
+};
+
+// The job system and worker the calling thread belongs to, if it is a worker
+static thread_local const BzfJobSystem *currentSystem = nullptr;
+static thread_local int currentWorker = -1;
+
+BzfJobSystem::BzfJobSystem(unsigned int workerCount) : mainThread(std::this_thread::get_id()), nextWorker(0),
+    stopping(false), queued(0), unfinished(0), jobCount(0), stealCount(0)
+{
+    if (workerCount == 0)
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        workerCount = (cores > 1) ? cores - 1 : 1;
+    }
+
+    // All deques have to exist before any worker starts stealing
+    for (unsigned int i = 0; i < workerCount; ++i)
+        workers.push_back(new Worker);
+    for (unsigned int i = 0; i < workerCount; ++i)
+        workers[i]->thread = std::thread(&BzfJobSystem::work, this, (int)i);
+}
+
+BzfJobSystem::~BzfJobSystem()
+{
+    // Jobs can depend on main-thread jobs, so those have to keep running until everything is done
+    while (unfinished > 0)
+    {
+        if (runMainThreadJobs() > 0)
+            continue;
+        std::unique_lock<std::mutex> lock(progressMutex);
+        progress.wait_for(lock, std::chrono::milliseconds(1));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto worker : workers)
+    {
+        worker->thread.join();
+        delete worker;
+    }
+}
+
+BzfJobHandle BzfJobSystem::submit(std::function<void()> work, const std::vector<BzfJobHandle> &dependencies)
+{
+    return create(work, false, dependencies);
+}
+
+BzfJobHandle BzfJobSystem::submitToMainThread(std::function<void()> work,
+        const std::vector<BzfJobHandle> &dependencies)
+{
+    return create(work, true, dependencies);
+}
+
+BzfJobHandle BzfJobSystem::create(std::function<void()> work, bool mainThreadJob,
+                                  const std::vector<BzfJobHandle> &dependencies)
+{
+    BzfJobHandle job = std::make_shared<BzfJob>();
+    job->work = work;
+    job->mainThread = mainThreadJob;
+    job->waitingFor = (int)dependencies.size() + 1;
+    job->finished = false;
+    ++unfinished;
+
+    for (auto &dependency : dependencies)
+    {
+        if (dependency != nullptr)
+        {
+            std::lock_guard<std::mutex> lock(dependency->mutex);
+            if (!dependency->finished)
+            {
+                dependency->dependents.push_back(job);
+                continue;
+            }
+        }
+        --job->waitingFor;
+    }
+
+    if (--job->waitingFor == 0)
+        schedule(job);
+    return job;
+}
+
+void BzfJobSystem::schedule(const BzfJobHandle &job)
+{
+    if (job->mainThread)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mainMutex);
+            mainJobs.push_back(job);
+        }
+        // The main thread may be waiting for a job that depends on this one
+        {
+            std::lock_guard<std::mutex> lock(progressMutex);
+        }
+        progress.notify_all();
+        return;
+    }
+
+    // A worker keeps what it submits, everybody else spreads their jobs over the workers
+    int index = workerIndex();
+    if (index < 0)
+        index = nextWorker++ % workers.size();
+
+    // Counted first, so that a worker that takes the job right away can not make the count negative
+    ++queued;
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->jobs.push_back(job);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    workAvailable.notify_one();
+}
+
+BzfJobHandle BzfJobSystem::take(int own)
+{
+    BzfJobHandle job;
+
+    if (own >= 0)
+    {
+        Worker *worker = workers[own];
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        if (!worker->jobs.empty())
+        {
+            job = worker->jobs.back();
+            worker->jobs.pop_back();
+        }
+    }
+
+    // Start with the next worker, so that thieves do not all go for the first one
+    unsigned int count = workers.size();
+    unsigned int start = (own >= 0) ? own + 1 : nextWorker.load();
+    for (unsigned int i = 0; job == nullptr && i < count; ++i)
+    {
+        int victim = (start + i) % count;
+        if (victim == own)
+            continue;
+        Worker *worker = workers[victim];
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        if (!worker->jobs.empty())
+        {
+            job = worker->jobs.front();
+            worker->jobs.pop_front();
+            ++stealCount;
+        }
+    }
+
+    if (job != nullptr)
+        --queued;
+    return job;
+}
+
+void BzfJobSystem::run(const BzfJobHandle &job)
+{
+    {
+        BZF_PROFILE_ZONE("job");
+        job->work();
+    }
+    finish(job);
+}
+
+void BzfJobSystem::finish(const BzfJobHandle &job)
+{
+    static BzfCounter *jobsRun = BzfMetrics::get().counter("jobs.run");
+
+    std::vector<BzfJobHandle> dependents;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->finished = true;
+        dependents.swap(job->dependents);
+        // Let go of whatever the work captured, as handles can be kept around for much longer
+        job->work = nullptr;
+    }
+    for (auto &dependent : dependents)
+    {
+        if (--dependent->waitingFor == 0)
+            schedule(dependent);
+    }
+
+    ++jobCount;
+    jobsRun->add();
+    {
+        std::lock_guard<std::mutex> lock(progressMutex);
+        --unfinished;
+    }
+    progress.notify_all();
+}
+
+void BzfJobSystem::work(int index)
+{
+    BZF_PROFILE_THREAD("job worker");
+    currentSystem = this;
+    currentWorker = index;
+
+    while (true)
+    {
+        BzfJobHandle job = take(index);
+        if (job != nullptr)
+        {
+            run(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        workAvailable.wait(lock, [this]()
+        {
+            return queued > 0 || stopping;
+        });
+        if (stopping && queued <= 0)
+            return;
+    }
+}
+
+void BzfJobSystem::wait(const BzfJobHandle &job)
+{
+    if (job == nullptr)
+        return;
+
+    bool main = onMainThread();
+    int own = workerIndex();
+    while (!job->finished)
+    {
+        if (main && runMainThreadJobs() > 0)
+            continue;
+
+        BzfJobHandle other = take(own);
+        if (other != nullptr)
+        {
+            run(other);
+            continue;
+        }
+
+        // Nothing to help with, so wait for the jobs that are running. The timeout covers jobs that become ready on
+        // another thread without finishing anything that this thread would be woken for.
+        std::unique_lock<std::mutex> lock(progressMutex);
+        progress.wait_for(lock, std::chrono::milliseconds(1), [&]()
+        {
+            return job->finished.load();
+        });
+    }
+}
+
+bool BzfJobSystem::isFinished(const BzfJobHandle &job)
+{
+    return job == nullptr || job->finished;
+}
+
+int BzfJobSystem::runMainThreadJobs()
+{
+    std::vector<BzfJobHandle> ready;
+    {
+        std::lock_guard<std::mutex> lock(mainMutex);
+        if (mainJobs.empty())
+            return 0;
+        ready.swap(mainJobs);
+    }
+
+    BZF_PROFILE_ZONE("BzfJobSystem::runMainThreadJobs");
+    for (auto &job : ready)
+        run(job);
+    return (int)ready.size();
+}
+
+unsigned int BzfJobSystem::getWorkerCount() const
+{
+    return workers.size();
+}
+
+unsigned long BzfJobSystem::getJobCount() const
+{
+    return jobCount;
+}
+
+unsigned long BzfJobSystem::getStealCount() const
+{
+    return stealCount;
+}
+
+bool BzfJobSystem::onMainThread() const
+{
+    return std::this_thread::get_id() == mainThread;
+}
+
+int BzfJobSystem::workerIndex() const
+{
+    return (currentSystem == this) ? currentWorker : -1;
+}
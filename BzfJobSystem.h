@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct BzfJob;
+// Keeps a job alive for as long as someone wants to wait for it or depend on it
+typedef std::shared_ptr<BzfJob> BzfJobHandle;
+
+// Runs work like loading files and decoding sounds on worker threads, so that it stays off the frame. There is a worker
+// per core, each with a deque of jobs. Jobs that a worker submits go to the back of its own deque and are taken from
+// there again, so that related work stays on a core whose caches have its data. A worker that runs out steals from the
+// front of the others' deques, where the oldest jobs are.
+//
+// A job can depend on other jobs, and only starts once they all finished. Jobs that have to run on the main thread,
+// like handing loaded data to OpenGL, are submitted with submitToMainThread() and are run from runMainThreadJobs(),
+// which the platform's frame pacer calls every frame. The main thread is the one that created the job system.
+//
+// Each deque is guarded by a mutex of its own rather than being lock-free, which costs little for jobs of the size we
+// have. Jobs must not throw.
+class BzfJobSystem
+{
+public:
+    // With 0 workers, one is started per hardware thread, except for one left to the main thread
+    explicit BzfJobSystem(unsigned int workers = 0);
+    // Waits for the submitted jobs, running the main-thread jobs among them, and stops the workers. Has to be called on
+    // the main thread.
+    ~BzfJobSystem();
+
+    // Run work on a worker once the dependencies have finished. Dependencies that are nullptr are ignored.
+    BzfJobHandle submit(std::function<void()> work, const std::vector<BzfJobHandle> &dependencies = {});
+    // Run work on the main thread, from runMainThreadJobs(), once the dependencies have finished
+    BzfJobHandle submitToMainThread(std::function<void()> work, const std::vector<BzfJobHandle> &dependencies = {});
+
+    // Block until the job has finished, running other jobs in the meantime (including main-thread jobs, when called on
+    // the main thread) rather than just sleeping
+    void wait(const BzfJobHandle &job);
+    static bool isFinished(const BzfJobHandle &job);
+
+    // Run the main-thread jobs that are ready and return how many there were. Jobs that these submit to the main thread
+    // are left for the next call.
+    int runMainThreadJobs();
+
+    unsigned int getWorkerCount() const;
+    // Statistics
+    unsigned long getJobCount() const;
+    // Jobs that a thread took from the deque of another worker
+    unsigned long getStealCount() const;
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<BzfJobHandle> jobs;
+        std::thread thread;
+    };
+
+    BzfJobHandle create(std::function<void()> work, bool mainThread, const std::vector<BzfJobHandle> &dependencies);
+    void schedule(const BzfJobHandle &job);
+    // Take a job from the back of the worker's own deque, or steal one from the front of another. A thread that is not
+    // a worker passes -1 and can only steal.
+    BzfJobHandle take(int own);
+    void run(const BzfJobHandle &job);
+    void finish(const BzfJobHandle &job);
+    void work(int index);
+    bool onMainThread() const;
+    // The index of the calling thread's worker, or -1 if it is not a worker of this system
+    int workerIndex() const;
+
+    std::vector<Worker*> workers;
+    std::thread::id mainThread;
+    std::atomic<unsigned int> nextWorker;
+    std::atomic<bool> stopping;
+
+    // Jobs in the workers' deques, which the workers sleep on while there are none
+    std::atomic<long> queued;
+    std::mutex sleepMutex;
+    std::condition_variable workAvailable;
+
+    std::mutex mainMutex;
+    std::vector<BzfJobHandle> mainJobs;
+
+    // Signalled whenever a job finishes or a main-thread job becomes ready, for wait()
+    std::atomic<unsigned long> unfinished;
+    std::mutex progressMutex;
+    std::condition_variable progress;
+
+    std::atomic<unsigned long> jobCount;
+    std::atomic<unsigned long> stealCount;
+};
@@ -0,0 +1,90 @@
+#include "BzfLatencyTracker.h"
+#include "BzfClock.h"
+
+#include "BzfGL.h"
+
+// How long to wait for the GPU before giving up on a frame, in nanoseconds
+static const GLuint64 fenceTimeout = 100000000;
+
+BzfLatencyTracker::BzfLatencyTracker() : enabled(false), pendingInput(0), frameInput(0),
+    latencies(new BzfHistogram(BzfMetrics::millisecondBounds()))
+{
+}
+
+void BzfLatencyTracker::setEnabled(bool enable)
+{
+    enabled = enable;
+    if (!enable)
+    {
+        pendingInput = 0;
+        frameInput = 0;
+    }
+}
+
+bool BzfLatencyTracker::isEnabled() const
+{
+    return enabled;
+}
+
+void BzfLatencyTracker::inputArrived(uint64_t ticks)
+{
+    if (!enabled || ticks == 0)
+        return;
+
+    // Keep the earliest arrival. Another thread can only ever consume it (set it to 0), so just try again then.
+    uint64_t pending = pendingInput.load(std::memory_order_relaxed);
+    while ((pending == 0 || ticks < pending)
+            && !pendingInput.compare_exchange_weak(pending, ticks, std::memory_order_relaxed))
+        ;
+}
+
+void BzfLatencyTracker::beginFrame()
+{
+    if (!enabled)
+        return;
+
+    uint64_t input = pendingInput.exchange(0, std::memory_order_relaxed);
+    // A frame that was not swapped (for instance because the window was hidden) passes its earlier input on
+    if (frameInput == 0)
+        frameInput = input;
+}
+
+void BzfLatencyTracker::frameSwapped(bool sync)
+{
+    static BzfHistogram *inputLatency = BzfMetrics::get().histogram("input.latency.ms",
+                                        BzfMetrics::millisecondBounds());
+
+    if (!enabled || frameInput == 0)
+        return;
+
+    // GL_ARB_sync is core since OpenGL 3.2 and ES 3.0. Without it, glFinish() waits for the same thing, just less
+    // politely.
+    if (sync)
+    {
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, fenceTimeout);
+        glDeleteSync(fence);
+        if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED)
+        {
+            frameInput = 0;
+            return;
+        }
+    }
+    else
+        glFinish();
+
+    double latency = BzfClock::toMilliseconds(BzfClock::now() - frameInput);
+    latencies->observe(latency);
+    inputLatency->observe(latency);
+    frameInput = 0;
+}
+
+const BzfHistogram& BzfLatencyTracker::getLatencies() const
+{
+    return *latencies;
+}
+
+void BzfLatencyTracker::resetLatencies()
+{
+    latencies.reset(new BzfHistogram(BzfMetrics::millisecondBounds()));
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "BzfMetrics.h"
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+
+// Measures input-to-photon latency for a window: the time from an input event arriving to the GPU finishing the first
+// frame that could show its effect. The backends tag input with its arrival time, the application marks where it
+// starts a frame (the input that arrived until then is what the frame consumes) and the swap is timed with a fence.
+//
+// Waiting on the fence keeps the CPU from running ahead of the GPU on frames that carry input, so this is a
+// measurement mode that is off by default rather than something to leave on while playing.
+class BzfLatencyTracker
+{
+public:
+    BzfLatencyTracker();
+
+    void setEnabled(bool enable);
+    bool isEnabled() const;
+
+    // Called by the backends for every input event, with its arrival time in BzfClock ticks. This can happen on any
+    // thread. Only the earliest input since the last frame started is kept, as that is the one that waited longest.
+    void inputArrived(uint64_t ticks);
+    // Called by the application on the thread that renders the window, right before it reads input for a frame
+    void beginFrame();
+    // Called by the backends right after the swap, with the context of the window current. sync tells whether the
+    // context has fences, see BzfGLCapabilities.
+    void frameSwapped(bool sync);
+
+    // Latency of recent frames that consumed input, in milliseconds
+    const BzfHistogram& getLatencies() const;
+    void resetLatencies();
+
+private:
+    std::atomic<bool> enabled;
+    // Arrival time of the earliest input that no frame has consumed yet, or 0 for none
+    std::atomic<uint64_t> pendingInput;
+    // Arrival time of the earliest input consumed by the frame being drawn, or 0 for none
+    uint64_t frameInput;
+    std::unique_ptr<BzfHistogram> latencies;
+};
@@ -0,0 +1,216 @@
+#include "BzfMetrics.h"
+
+#include <stdio.h>
+
+BzfHistogram::BzfHistogram(const std::vector<double> &_bounds) : bounds(_bounds),
+    buckets(new std::atomic<uint64_t>[_bounds.size() + 1]), count(0), sum(0.0)
+{
+    for (size_t i = 0; i <= bounds.size(); ++i)
+        buckets[i] = 0;
+}
+
+void BzfHistogram::observe(double value)
+{
+    size_t bucket = 0;
+    while (bucket < bounds.size() && value > bounds[bucket])
+        ++bucket;
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+
+    double current = sum.load(std::memory_order_relaxed);
+    while (!sum.compare_exchange_weak(current, current + value, std::memory_order_relaxed))
+        ;
+}
+
+uint64_t BzfHistogram::getCount() const
+{
+    return count.load(std::memory_order_relaxed);
+}
+
+double BzfHistogram::getSum() const
+{
+    return sum.load(std::memory_order_relaxed);
+}
+
+double BzfHistogram::getMean() const
+{
+    uint64_t n = getCount();
+    return n > 0 ? getSum() / n : 0.0;
+}
+
+double BzfHistogram::getPercentile(double fraction) const
+{
+    uint64_t wanted = (uint64_t)(fraction * getCount() + 0.5);
+    uint64_t seen = 0;
+    for (size_t i = 0; i <= bounds.size(); ++i)
+    {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= wanted && seen > 0)
+            return bounds[i < bounds.size() ? i : bounds.size() - 1];
+    }
+    return 0.0;
+}
+
+int BzfHistogram::getBucketCount() const
+{
+    return (int)bounds.size() + 1;
+}
+
+double BzfHistogram::getBound(int bucket) const
+{
+    if (bucket < 0 || bucket >= (int)bounds.size())
+        return 0.0;
+    return bounds[bucket];
+}
+
+uint64_t BzfHistogram::getBucket(int bucket) const
+{
+    if (bucket < 0 || bucket > (int)bounds.size())
+        return 0;
+    return buckets[bucket].load(std::memory_order_relaxed);
+}
+
+BzfMetrics::BzfMetrics() : dumpInterval(0.0), nextDump(0.0)
+{
+}
+
+BzfMetrics& BzfMetrics::get()
+{
+    static BzfMetrics metrics;
+    return metrics;
+}
+
+BzfCounter* BzfMetrics::counter(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<BzfCounter> &metric = counters[name];
+    if (!metric)
+        metric.reset(new BzfCounter);
+    return metric.get();
+}
+
+BzfGauge* BzfMetrics::gauge(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<BzfGauge> &metric = gauges[name];
+    if (!metric)
+        metric.reset(new BzfGauge);
+    return metric.get();
+}
+
+BzfHistogram* BzfMetrics::histogram(const std::string &name, const std::vector<double> &bounds)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<BzfHistogram> &metric = histograms[name];
+    if (!metric)
+        metric.reset(new BzfHistogram(bounds));
+    return metric.get();
+}
+
+std::vector<double> BzfMetrics::millisecondBounds()
+{
+    // Frames at 60 and 30 Hz fall right between two bounds
+    return { 1, 2, 4, 8, 12, 16, 17, 20, 25, 33, 34, 50, 67, 100 };
+}
+
+bool BzfMetrics::writeJSON(const std::string &filename) const
+{
+    FILE *file = fopen(filename.c_str(), "w");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Could not write the metrics to %s\n", filename.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    bool first = true;
+
+    fprintf(file, "{\n  \"counters\": {");
+    for (auto &counter : counters)
+    {
+        fprintf(file, "%s\n    \"%s\": %llu", first ? "" : ",", counter.first.c_str(),
+                (unsigned long long)counter.second->get());
+        first = false;
+    }
+
+    first = true;
+    fprintf(file, "\n  },\n  \"gauges\": {");
+    for (auto &gauge : gauges)
+    {
+        fprintf(file, "%s\n    \"%s\": %g", first ? "" : ",", gauge.first.c_str(), gauge.second->get());
+        first = false;
+    }
+
+    first = true;
+    fprintf(file, "\n  },\n  \"histograms\": {");
+    for (auto &entry : histograms)
+    {
+        const BzfHistogram &histogram = *entry.second;
+        fprintf(file, "%s\n    \"%s\": { \"count\": %llu, \"mean\": %g, \"p50\": %g, \"p99\": %g, \"buckets\": [",
+                first ? "" : ",", entry.first.c_str(), (unsigned long long)histogram.getCount(), histogram.getMean(),
+                histogram.getPercentile(0.5), histogram.getPercentile(0.99));
+        for (int i = 0; i < histogram.getBucketCount(); ++i)
+            fprintf(file, "%s%llu", i == 0 ? "" : ", ", (unsigned long long)histogram.getBucket(i));
+        fprintf(file, "] }");
+        first = false;
+    }
+    fprintf(file, "\n  }\n}\n");
+
+    fclose(file);
+    return true;
+}
+
+bool BzfMetrics::appendCSV(const std::string &filename, double time) const
+{
+    FILE *file = fopen(filename.c_str(), "a");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Could not write the metrics to %s\n", filename.c_str());
+        return false;
+    }
+
+    // Start a new file with a header
+    if (ftell(file) == 0)
+        fprintf(file, "time,name,value,mean,p50,p99\n");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &counter : counters)
+        fprintf(file, "%.3f,%s,%llu,,,\n", time, counter.first.c_str(), (unsigned long long)counter.second->get());
+    for (auto &gauge : gauges)
+        fprintf(file, "%.3f,%s,%g,,,\n", time, gauge.first.c_str(), gauge.second->get());
+    for (auto &entry : histograms)
+    {
+        const BzfHistogram &histogram = *entry.second;
+        fprintf(file, "%.3f,%s,%llu,%g,%g,%g\n", time, entry.first.c_str(), (unsigned long long)histogram.getCount(),
+                histogram.getMean(), histogram.getPercentile(0.5), histogram.getPercentile(0.99));
+    }
+
+    fclose(file);
+    return true;
+}
+
+void BzfMetrics::setPeriodicDump(const std::string &filename, double interval)
+{
+    dumpFilename = filename;
+    dumpInterval = interval;
+    nextDump = 0.0;
+}
+
+void BzfMetrics::dumpIfDue(double time)
+{
+    if (dumpFilename.empty() || dumpInterval <= 0.0)
+        return;
+
+    if (nextDump == 0.0)
+        nextDump = time + dumpInterval;
+    if (time < nextDump)
+        return;
+    nextDump = time + dumpInterval;
+
+    const std::string extension = ".json";
+    if (dumpFilename.size() >= extension.size()
+            && dumpFilename.compare(dumpFilename.size() - extension.size(), extension.size(), extension) == 0)
+        writeJSON(dumpFilename);
+    else
+        appendCSV(dumpFilename, time);
+}
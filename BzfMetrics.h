@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A count of something that happened, which only goes up
+class BzfCounter
+{
+public:
+    BzfCounter() : value(0) {}
+
+    void add(uint64_t amount = 1)
+    {
+        value.fetch_add(amount, std::memory_order_relaxed);
+    }
+    uint64_t get() const
+    {
+        return value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> value;
+};
+
+// The latest value of something
+class BzfGauge
+{
+public:
+    BzfGauge() : value(0.0) {}
+
+    void set(double _value)
+    {
+        value.store(_value, std::memory_order_relaxed);
+    }
+    // For gauges that several owners contribute to, like the windows of all platforms
+    void add(double delta)
+    {
+        double current = value.load(std::memory_order_relaxed);
+        while (!value.compare_exchange_weak(current, current + delta, std::memory_order_relaxed))
+            ;
+    }
+    double get() const
+    {
+        return value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<double> value;
+};
+
+// Counts values into buckets with fixed upper bounds. Values above the last bound go into an extra overflow bucket.
+class BzfHistogram
+{
+public:
+    BzfHistogram(const std::vector<double> &bounds);
+
+    void observe(double value);
+
+    uint64_t getCount() const;
+    double getSum() const;
+    double getMean() const;
+    // Upper bound of the bucket holding the given fraction of the values, or the last bound for the overflow bucket
+    double getPercentile(double fraction) const;
+    // Bounds plus the overflow bucket
+    int getBucketCount() const;
+    double getBound(int bucket) const;
+    uint64_t getBucket(int bucket) const;
+
+private:
+    std::vector<double> bounds;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+    std::atomic<uint64_t> count;
+    std::atomic<double> sum;
+};
+
+// Named counters, gauges and histograms shared by the whole process. Looking one up takes a lock, so hot paths should
+// keep the pointer, which stays valid for the lifetime of the program. Updating them is lock free.
+class BzfMetrics
+{
+public:
+    static BzfMetrics& get();
+
+    BzfCounter* counter(const std::string &name);
+    BzfGauge* gauge(const std::string &name);
+    // The bounds are only used when the histogram does not exist yet
+    BzfHistogram* histogram(const std::string &name, const std::vector<double> &bounds);
+    // Bounds for durations in milliseconds, from 1 to 100 ms
+    static std::vector<double> millisecondBounds();
+
+    // Write all metrics as a JSON object
+    bool writeJSON(const std::string &filename) const;
+    // Append a line per metric to a CSV file, with the time (in seconds) of the dump in the first column
+    bool appendCSV(const std::string &filename, double time) const;
+
+    // Dump to a file every interval seconds, as JSON when the name ends in .json and CSV otherwise
+    void setPeriodicDump(const std::string &filename, double interval);
+    // Call regularly (for instance once a frame) with the current time, to do the periodic dump
+    void dumpIfDue(double time);
+
+private:
+    BzfMetrics();
+
+    mutable std::mutex mutex;
+    std::map<std::string, std::unique_ptr<BzfCounter>> counters;
+    std::map<std::string, std::unique_ptr<BzfGauge>> gauges;
+    std::map<std::string, std::unique_ptr<BzfHistogram>> histograms;
+
+    std::string dumpFilename;
+    double dumpInterval;
+    double nextDump;
+};
@@ -1,4 +1,77 @@
 #include "BzfPlatform.h"
+#include "BzfFramePacer.h"
+#include "BzfJobSystem.h"
+#include "BzfMetrics.h"
+
+#include <stdio.h>
+
+BzfPlatform::BzfPlatform() : framePacer(new BzfFramePacer(this, true)), jobSystem(nullptr),
+    idleInterval(0.0), sharedContexts(false)
+{
+#ifdef _DEBUG
+    // For debugging, set the start time of the program to be 184 days in the past to catch issues that may occur with long running programs
+    startTicks = BzfClock::now() - BzfClock::ticksPerSecond * 60 * 60 * 24 * 184;
+#else
+    startTicks = BzfClock::now();
+#endif
+}
+
+BzfPlatform::~BzfPlatform()
+{
+    // Normally done by the destructor of the backend already
+    shutdownJobSystem();
+    delete framePacer;
+}
+
+BzfFramePacer* BzfPlatform::getFramePacer()
+{
+    return framePacer;
+}
+
+BzfJobSystem* BzfPlatform::getJobSystem()
+{
+    // Made on first use, so that platforms that never submit anything, like the bots of a load test, have no workers
+    if (jobSystem == nullptr)
+        jobSystem = new BzfJobSystem;
+    return jobSystem;
+}
+
+void BzfPlatform::shutdownJobSystem()
+{
+    delete jobSystem;
+    jobSystem = nullptr;
+}
+
+void BzfPlatform::runMainThreadJobs()
+{
+    if (jobSystem != nullptr)
+        jobSystem->runMainThreadJobs();
+}
+
+void BzfPlatform::GLSetSharedContexts(bool share)
+{
+    sharedContexts = share;
+}
+
+bool BzfPlatform::GLGetSharedContexts() const
+{
+    return sharedContexts;
+}
+
+void BzfPlatform::setIdleInterval(double seconds)
+{
+    idleInterval = seconds > 0.0 ? seconds : 0.0;
+}
+
+double BzfPlatform::getIdleInterval() const
+{
+    return idleInterval;
+}
+
+bool BzfPlatform::isIdle() const
+{
+    return idleInterval > 0.0 && !hasVisibleWindow();
+}
 
 void BzfPlatform::addResizeCallback(std::function<void(BzfPlatform *, BzfWindow *, int, int)> callback)
 {
@@ -13,37 +86,201 @@ void BzfPlatform::addMoveCallback(std::function<void(BzfPlatform *, BzfWindow *,
 void BzfPlatform::setKeyCallback(std::function<void(BzfPlatform *, BzfWindow *, BzfKey, BzfKeyAction, int)> callback)
 {
     keyCallback = callback;
+    callbacksChanged();
 }
 
 void BzfPlatform::setTextCallback(std::function<void(BzfPlatform *, BzfWindow *, char[32])> callback)
 {
     textCallback = callback;
+    callbacksChanged();
 }
 
 void BzfPlatform::setCursorPosCallback(std::function<void(BzfPlatform *, BzfWindow *, double, double)> callback)
 {
     cursorPosCallback = callback;
+    callbacksChanged();
 }
 
 void BzfPlatform::setMouseButtonCallback(
     std::function<void(BzfPlatform *, BzfWindow *, BzfMouseButton, BzfButtonAction, int)> callback)
 {
     mouseButtonCallback = callback;
+    callbacksChanged();
 }
 
 void BzfPlatform::setScrollCallback(std::function<void(BzfPlatform *, BzfWindow *, double, double)> callback)
 {
     scrollCallback = callback;
+    callbacksChanged();
 }
 
 void BzfPlatform::setJoystickButtonCallback(
     std::function<void(BzfPlatform *, BzfWindow *, BzfJoyButton, BzfButtonAction)> callback)
 {
     joystickButtonCallback = callback;
+    callbacksChanged();
 }
 
 void BzfPlatform::setJoystickHatCallback(std::function<void(BzfPlatform *, BzfWindow *, BzfJoyHat, BzfJoyHatDirection)>
         callback)
 {
     joystickHatCallback = callback;
+    callbacksChanged();
+}
+
+// 0 is left for no context
+static std::atomic<uint64_t> nextContextId(1);
+
+BzfWindow::BzfWindow() : contextSwitches(0), contextId(nextContextId++), swapPolicy(BZF_SWAP_OFF),
+    refreshInterval(1.0 / 60.0), glCapabilities(), stateVersion(0), autoAdaptiveSync(false), lastSwapTime(0),
+    userPointer(nullptr)
+{
+    // Until the backend reports otherwise, since new windows normally get the focus
+    state.width = state.height = 0;
+    state.drawableWidth = state.drawableHeight = 0;
+    state.x = state.y = 0;
+    state.fullscreen = false;
+    state.focused = true;
+    state.minimized = false;
+    state.hidden = false;
+    state.displayIndex = 0;
+}
+
+BzfWindowState BzfWindow::getState() const
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return state;
+}
+
+bool BzfWindow::isFullscreen() const
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return state.fullscreen;
+}
+
+bool BzfWindow::getWindowSize(int &width, int &height) const
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    width = state.width;
+    height = state.height;
+    return true;
+}
+
+bool BzfWindow::getDrawableSize(int &width, int &height) const
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    width = state.drawableWidth;
+    height = state.drawableHeight;
+    return true;
+}
+
+void BzfWindow::getPosition(int &x, int &y) const
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    x = state.x;
+    y = state.y;
+}
+
+int BzfWindow::getDisplayIndex() const
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return state.displayIndex;
+}
+
+bool BzfWindow::isMinimized() const
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return state.minimized;
+}
+
+bool BzfWindow::isHidden() const
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return state.minimized || state.hidden;
+}
+
+bool BzfWindow::hasFocus() const
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return state.focused;
+}
+
+void BzfWindow::setState(const BzfWindowState &newState)
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (newState.width == state.width && newState.height == state.height
+            && newState.drawableWidth == state.drawableWidth && newState.drawableHeight == state.drawableHeight
+            && newState.x == state.x && newState.y == state.y && newState.fullscreen == state.fullscreen
+            && newState.focused == state.focused && newState.minimized == state.minimized && newState.hidden == state.hidden
+            && newState.displayIndex == state.displayIndex)
+        return;
+    state = newState;
+    stateVersion++;
+}
+
+bool BzfWindow::setVerticalSync(bool sync) const
+{
+    if (sync)
+        return setSwapPolicy(BZF_SWAP_ADAPTIVE) != BZF_SWAP_OFF;
+    return setSwapPolicy(BZF_SWAP_OFF) == BZF_SWAP_OFF;
+}
+
+void BzfWindow::recordSwap() const
+{
+    static BzfCounter *swaps = BzfMetrics::get().counter("swaps");
+    static BzfHistogram *swapIntervals = BzfMetrics::get().histogram("swap.interval.ms", BzfMetrics::millisecondBounds());
+
+    uint64_t now = BzfClock::now();
+    if (lastSwapTime != 0)
+    {
+        swapHistogram.add(BzfClock::toSeconds(now - lastSwapTime));
+        swapIntervals->observe(BzfClock::toMilliseconds(now - lastSwapTime));
+    }
+    lastSwapTime = now;
+    swaps->add();
+    latencyTracker.frameSwapped(glCapabilities.sync);
+    framesInFlight.frameSwapped(glCapabilities.sync);
+
+    // Wait for a full history so that a single hitch (like the first frames after a resize) does not trigger this
+    if (autoAdaptiveSync && swapPolicy == BZF_SWAP_ON && swapHistogram.getCount() == BzfSwapHistogram::historySize
+            && swapHistogram.getMissedCount(getSwapDeadline()) > BzfSwapHistogram::historySize / 20)
+    {
+        if (setSwapPolicy(BZF_SWAP_ADAPTIVE) == BZF_SWAP_ADAPTIVE)
+            printf("Too many frames missed the refresh deadline, switched %p to adaptive sync\n",
+                   static_cast<const void*>(this));
+        else
+            // Not supported, so do not try again on every swap
+            autoAdaptiveSync = false;
+        swapHistogram.clear();
+    }
+}
+
+double BzfWindow::getSwapDeadline() const
+{
+    int interval = swapIntervalFor(swapPolicy);
+    return refreshInterval * (interval > 1 ? interval : 1);
+}
+
+int BzfWindow::swapIntervalFor(BzfSwapPolicy policy)
+{
+    switch(policy)
+    {
+    // *INDENT-OFF*
+    case BZF_SWAP_ON: return 1;
+    case BZF_SWAP_ADAPTIVE: return -1;
+    case BZF_SWAP_HALF_RATE: return 2;
+    default: return 0;
+    // *INDENT-ON*
+    }
+}
+
+BzfSwapPolicy BzfWindow::swapPolicyFor(int interval)
+{
+    if (interval < 0)
+        return BZF_SWAP_ADAPTIVE;
+    if (interval == 0)
+        return BZF_SWAP_OFF;
+    if (interval == 1)
+        return BZF_SWAP_ON;
+    return BZF_SWAP_HALF_RATE;
 }
@@ -1,10 +1,17 @@
 #pragma once
 
+#include "BzfGL.h"
 #include "BzfKeys.h"
+#include "BzfClock.h"
+#include "BzfSwapHistogram.h"
+#include "BzfLatencyTracker.h"
+#include "BzfFramesInFlight.h"
 
 #include <vector>
 #include <string>
 #include <functional>
+#include <atomic>
+#include <mutex>
 
 struct BzfResolution
 {
@@ -19,6 +26,8 @@ struct BzfMonitor
 };
 
 class BzfWindow;
+class BzfFramePacer;
+class BzfJobSystem;
 class BzfAudio;
 class BzfJoystick;
 struct BzfJoystickInfo;
@@ -30,6 +39,17 @@ typedef enum
     BZF_MOUSE_CONFINED_BOX = 2
 } BzfMouseConfinement;
 
+typedef enum
+{
+    BZF_SWAP_OFF = 0,
+    // Wait for vertical sync
+    BZF_SWAP_ON = 1,
+    // Wait for vertical sync, unless the frame is already late, in which case swap right away and tear
+    BZF_SWAP_ADAPTIVE = 2,
+    // Wait for every other vertical sync
+    BZF_SWAP_HALF_RATE = 3
+} BzfSwapPolicy;
+
 typedef enum bzfglprofile
 {
     BzfGLCompatibility,
@@ -37,6 +57,36 @@ typedef enum bzfglprofile
     BzfGLES
 } BzfGLProfile;
 
+// Flags for BzfPlatform::GLSetContextFlags(), which can be combined
+typedef enum
+{
+    // Have the driver check everything and explain problems through its debug output, see GLDebugOutput
+    BZF_GL_CONTEXT_DEBUG = 1,
+    // Have the driver skip checking for errors (KHR_no_error), which saves CPU time on every call. Errors then lead to
+    // undefined behavior instead. Ignored together with BZF_GL_CONTEXT_DEBUG, or where it is not supported.
+    BZF_GL_CONTEXT_NO_ERROR = 2,
+    // Out of bounds accesses can not crash or read other data
+    BZF_GL_CONTEXT_ROBUST = 4
+} BzfGLContextFlag;
+
+// What the window system last reported about a window. Sizes are in screen coordinates, except for the drawable size,
+// which is in pixels and differs from the window size on HiDPI displays.
+struct BzfWindowState
+{
+    int width;
+    int height;
+    int drawableWidth;
+    int drawableHeight;
+    int x;
+    int y;
+    bool fullscreen;
+    bool focused;
+    bool minimized;
+    bool hidden;
+    // Index of the display that the window is on, in the order of BzfPlatform::getMonitors()
+    int displayIndex;
+};
+
 #define BZF_ICON_SIZE 64
 
 struct BzfIcon
@@ -50,12 +100,15 @@ struct BzfIcon
 class BzfPlatform
 {
 public:
-    BzfPlatform() {}
-    virtual ~BzfPlatform() {}
+    BzfPlatform();
+    virtual ~BzfPlatform();
 
     virtual BzfWindow* createWindow(int width, int height, BzfMonitor* monitor = nullptr, int positionX = -1,
                                     int positionY = -1) = 0;
     virtual BzfWindow* createWindow(BzfResolution resolution, BzfMonitor* monitor = nullptr) = 0;
+    // Close and delete a window made by createWindow(). Windows that are left are deleted with the platform. A context
+    // that is current on another thread has to be released there first, like BzfRenderThread::stop() does.
+    virtual void destroyWindow(BzfWindow* window) = 0;
 
     // Audio
     virtual BzfAudio* getAudio() = 0;
@@ -67,7 +120,33 @@ public:
 
     // Timers
     // TODO: Do we actually need this or is our TimeKeeper class enough?
-    virtual double getGameTime() const = 0;
+    // Nanoseconds since the platform was created, see BzfClock
+    // Defined here so that calls through the backend types of BzfBackend.h can be inlined
+    virtual uint64_t getGameTicks() const
+    {
+        return BzfClock::now() - startTicks;
+    }
+    static uint64_t getGameTickFrequency()
+    {
+        return BzfClock::ticksPerSecond;
+    }
+    // Seconds since the platform was created. Prefer the ticks for measuring short intervals.
+    double getGameTime() const
+    {
+        return BzfClock::toSeconds(getGameTicks());
+    }
+
+    // Frame pacing
+    // The pacer of the main loop, which also polls the events. Without a target frame rate it only does the polling.
+    BzfFramePacer* getFramePacer();
+
+    // Jobs
+    // The job system for loading and other work off the main thread, whose workers are started by the first call. Its
+    // main-thread jobs are run by the frame pacer. Has to be called on the main thread. The jobs that are left when the
+    // platform is deleted are finished before the windows are destroyed.
+    BzfJobSystem* getJobSystem();
+    // Run the main-thread jobs that are ready, if there is a job system
+    void runMainThreadJobs();
 
     // Monitors
     // When monitor is nullptr, assume the primary display
@@ -82,10 +161,28 @@ public:
     // Set minumum color depth
     // TODO: Is there a reason to have this and not just hard-code some values?
     virtual void GLSetRGBA(unsigned short red, unsigned short green, unsigned short blue, unsigned short alpha) const = 0;
+    // Set the BzfGLContextFlag flags of the contexts created after this. None are set by default.
+    virtual void GLSetContextFlags(int flags) const = 0;
+    // Windows created while this is on share the objects of the first window's context, so that programs, buffers and
+    // textures only have to be made once. Vertex array and framebuffer objects are never shared. Off by default.
+    void GLSetSharedContexts(bool share);
+    bool GLGetSharedContexts() const;
 
     // Events
     // This will poll for events and call any set callbacks
     virtual void pollEvents() = 0;
+    // Like pollEvents(), but first wait up to timeout seconds for an event to arrive
+    virtual void waitEvents(double timeout) = 0;
+
+    // Idle mode
+    // Whether any window is shown, which is neither minimized nor hidden
+    virtual bool hasVisibleWindow() const = 0;
+    // While no window is visible, the platform's frame pacer blocks in waitEvents() for up to the interval (in seconds)
+    // instead of running at its target frame rate. 0 turns this off, which is the default.
+    void setIdleInterval(double seconds);
+    double getIdleInterval() const;
+    // Whether idle mode is on and there is nothing to draw for
+    bool isIdle() const;
 
     // Add a callback for the window resize event
     // Callback arguments: BzfPlatform, BzfWindow, viewportWidth, viewportHeight
@@ -120,6 +217,13 @@ public:
     virtual void stopTextInput() = 0;
     virtual bool isTextInput() = 0;
 
+protected:
+    // Called after one of the set*Callback() methods, so that a backend can stop producing events nobody listens to
+    virtual void callbacksChanged() {}
+    // Finish the submitted jobs, including their main-thread continuations, and stop the workers. Jobs may still be
+    // using the windows or the backend, so the destructor of every backend calls this before it takes anything down.
+    void shutdownJobSystem();
+
 #ifdef USE_GLFW
 public:
 #else
@@ -134,6 +238,13 @@ protected:
     std::function<void(BzfPlatform*,BzfWindow*,double,double)> scrollCallback;
     std::function<void(BzfPlatform*,BzfWindow*,BzfJoyButton,BzfButtonAction)> joystickButtonCallback;
     std::function<void(BzfPlatform*,BzfWindow*,BzfJoyHat,BzfJoyHatDirection)> joystickHatCallback;
+
+private:
+    BzfFramePacer *framePacer;
+    BzfJobSystem *jobSystem;
+    uint64_t startTicks;
+    double idleInterval;
+    bool sharedContexts;
 };
 
 class BzfWindow
@@ -143,14 +254,34 @@ public:
     // Child classes will use the following format for their constructors:
     // ChildClassWindow(int width, int height, ChildClassMonitor* monitor = nullptr, int positionX = -1, int positionY = -1);
     // ChildClassWindow(BzfResolution resolution, ChildClassMonitor* monitor = nullptr);
-    BzfWindow() : userPointer(nullptr) {};
+    BzfWindow();
     // Clean up and destroy the window
     virtual ~BzfWindow() {};
 
+    // Window state
+    // The getters below are served from a copy that the backends keep up to date from the window system's events, so
+    // they are cheap and can be called from any thread.
+    BzfWindowState getState() const;
+    // Changes whenever the state does, so that a renderer can tell whether it needs to look at the state again
+    unsigned long getStateVersion() const
+    {
+        return stateVersion;
+    }
+    bool isFullscreen() const;
+    // Size in screen coordinates, which is what cursor positions are given in
+    bool getWindowSize(int &width, int &height) const;
+    // Size of the framebuffer in pixels, which is what the viewport has to be set to
+    bool getDrawableSize(int &width, int &height) const;
+    void getPosition(int &x, int &y) const;
+    int getDisplayIndex() const;
+    bool isMinimized() const;
+    // Minimized or otherwise not shown, so that drawing it is wasted
+    bool isHidden() const;
+    bool hasFocus() const;
+
     // Fullscreen/Windowed
-    virtual bool isFullscreen() const = 0;
-    virtual bool setVerticalSync(bool sync) const = 0;
-    virtual bool getWindowSize(int &width, int &height) const = 0;
+    // Turn vertical sync on (adaptive where supported) or off. Returns false if that could not be done.
+    bool setVerticalSync(bool sync) const;
     virtual bool setWindowed(int width, int height, BzfMonitor* monitor = nullptr, int x = -1, int y = -1) = 0;
     virtual bool setFullscreen(BzfResolution resolution, BzfMonitor* monitor = nullptr) = 0;
     virtual void iconify() const = 0;
@@ -167,8 +298,61 @@ public:
     virtual BzfMouseConfinement getConfineMouse() = 0;
 
     // Drawing/context
+    // Making a context current that is already current on the calling thread does nothing
     virtual void makeContextCurrent() const = 0;
+    // Release the context from the calling thread, so that another thread can make it current
+    virtual void releaseContext() const = 0;
     virtual void swapBuffers() const = 0;
+    // Swap policy
+    // Request a swap policy for the context, which has to be current. Returns the policy that is actually in effect,
+    // which can differ when the driver does not support the one asked for.
+    virtual BzfSwapPolicy setSwapPolicy(BzfSwapPolicy policy) const = 0;
+    BzfSwapPolicy getSwapPolicy() const
+    {
+        return swapPolicy;
+    }
+    // Switch from BZF_SWAP_ON to BZF_SWAP_ADAPTIVE by itself once too many recent swaps missed the refresh deadline
+    void setAutoAdaptiveSync(bool enable)
+    {
+        autoAdaptiveSync = enable;
+    }
+    // Measured time between recent swaps
+    const BzfSwapHistogram& getSwapHistogram() const
+    {
+        return swapHistogram;
+    }
+    // Duration of a refresh of the display the window was on when the swap policy was last set, in seconds
+    double getRefreshInterval() const
+    {
+        return refreshInterval;
+    }
+    // Time a frame has under the swap policy before it misses its swap, in seconds. Without vertical sync and with
+    // adaptive sync, this is a refresh.
+    double getSwapDeadline() const;
+    // Bound on the frames the GPU can be behind, which is off until a limit is set
+    BzfFramesInFlight& getFramesInFlight()
+    {
+        return framesInFlight;
+    }
+    // Input-to-photon latency measurement, which is off until enabled
+    BzfLatencyTracker& getLatencyTracker()
+    {
+        return latencyTracker;
+    }
+    // What the window's context supports, found when it was created
+    const BzfGLCapabilities& getGLCapabilities() const
+    {
+        return glCapabilities;
+    }
+    // Number of times makeContextCurrent() actually had to switch to this window's context
+    unsigned long getContextSwitchCount() const
+    {
+        return contextSwitches;
+    }
+    void resetContextSwitchCount()
+    {
+        contextSwitches = 0;
+    }
 
     // Gamma control
     virtual void setGamma(float gamma) = 0;
@@ -184,7 +368,36 @@ public:
     {
         return userPointer;
     }
+protected:
+    // Backends call this right after every swap
+    void recordSwap() const;
+    // Swap interval for a policy, as taken by SDL_GL_SetSwapInterval() and glfwSwapInterval(), and back
+    static int swapIntervalFor(BzfSwapPolicy policy);
+    static BzfSwapPolicy swapPolicyFor(int interval);
+
+    mutable std::atomic<unsigned long> contextSwitches;
+    // Unique over the life of the process, unlike the address of a window. The backends remember which context is
+    // current on each thread by it, and a thread that still holds the id of a destroyed window never mistakes a new
+    // window for that one.
+    const uint64_t contextId;
+    // The granted swap policy and refresh interval, set by the backends' setSwapPolicy()
+    mutable BzfSwapPolicy swapPolicy;
+    mutable double refreshInterval;
+    // Backends call this with what the window system reports, whenever it may have changed
+    void setState(const BzfWindowState &newState);
+    // Backends fill this in through loadGLFunctions() once the context is current
+    BzfGLCapabilities glCapabilities;
 private:
+    mutable std::mutex stateMutex;
+    BzfWindowState state;
+    std::atomic<unsigned long> stateVersion;
+
+    mutable bool autoAdaptiveSync;
+    mutable uint64_t lastSwapTime;
+    mutable BzfSwapHistogram swapHistogram;
+    mutable BzfLatencyTracker latencyTracker;
+    mutable BzfFramesInFlight framesInFlight;
+
     void* userPointer;
     BzfMouseConfinement mouseConfinementMode;
 };
@@ -205,6 +418,7 @@ public:
     virtual int getAudioOutputRate() const = 0;
     virtual int getAudioBufferChunkSize() const = 0;
     virtual void writeAudioFrames(const float* samples, int numFrames) = 0;
+    // Only reads the settings of the audio, so sounds can be loaded from several jobs at once
     virtual float* doReadSound(const std::string& filename, int& numFrames, int& rate) const = 0;
 };
 
@@ -0,0 +1,200 @@
+#include "BzfProfiler.h"
+#include "BzfClock.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <stdio.h>
+
+struct ProfileEvent
+{
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+};
+
+// Only the owning thread writes to a buffer. It publishes each event by storing the new count with release
+// semantics, so the writer of the trace can read everything below the count without a lock.
+struct BzfProfileBuffer
+{
+    static const unsigned int capacity = 1 << 16;
+
+    BzfProfileBuffer(int _id) : id(_id), name(nullptr), generation(0), count(0), dropped(0)
+    {
+        events = new ProfileEvent[capacity];
+    }
+
+    int id;
+    std::atomic<const char*> name;
+    // Capture this buffer holds events of. A thread finding a newer one empties its buffer before writing.
+    std::atomic<unsigned int> generation;
+    std::atomic<unsigned int> count;
+    std::atomic<unsigned long> dropped;
+    ProfileEvent *events;
+};
+
+static std::atomic<bool> capturing(false);
+static std::atomic<unsigned int> captureGeneration(0);
+static std::atomic<uint64_t> captureStart(0);
+
+// Buffers are never freed, since a thread that exited may still have events that have not been written out
+static std::mutex buffersMutex;
+static std::vector<BzfProfileBuffer*> buffers;
+// The buffer of the calling thread, made on its first event unless it adopted one
+static thread_local BzfProfileBuffer *currentBuffer = nullptr;
+
+static BzfProfileBuffer* newBuffer()
+{
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    BzfProfileBuffer *buffer = new BzfProfileBuffer((int)buffers.size() + 1);
+    buffers.push_back(buffer);
+    return buffer;
+}
+
+static BzfProfileBuffer* threadBuffer()
+{
+    if (currentBuffer == nullptr)
+        currentBuffer = newBuffer();
+    return currentBuffer;
+}
+
+static void writeEscaped(FILE *file, const char *text)
+{
+    for (; *text != '\0'; ++text)
+    {
+        if (*text == '"' || *text == '\\')
+            fputc('\\', file);
+        if ((unsigned char)*text >= 0x20)
+            fputc(*text, file);
+    }
+}
+
+void BzfProfiler::start()
+{
+    captureStart = BzfClock::now();
+    ++captureGeneration;
+    capturing = true;
+}
+
+void BzfProfiler::stop()
+{
+    capturing = false;
+}
+
+bool BzfProfiler::isCapturing()
+{
+    return capturing;
+}
+
+void BzfProfiler::setThreadName(const char *name)
+{
+    threadBuffer()->name = name;
+}
+
+BzfProfileBuffer* BzfProfiler::reserveBuffer()
+{
+    return newBuffer();
+}
+
+void BzfProfiler::adoptBuffer(BzfProfileBuffer *buffer)
+{
+    if (currentBuffer == nullptr)
+        currentBuffer = buffer;
+}
+
+void BzfProfiler::addZone(const char *name, uint64_t start, uint64_t end)
+{
+    if (!capturing.load(std::memory_order_relaxed))
+        return;
+
+    BzfProfileBuffer *buffer = threadBuffer();
+    unsigned int generation = captureGeneration.load(std::memory_order_acquire);
+    if (buffer->generation.load(std::memory_order_relaxed) != generation)
+    {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->generation.store(generation, std::memory_order_release);
+    }
+
+    unsigned int index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= BzfProfileBuffer::capacity)
+    {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer->events[index].name = name;
+    buffer->events[index].start = start;
+    buffer->events[index].end = end;
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+bool BzfProfiler::writeTrace(const std::string &filename)
+{
+    FILE *file = fopen(filename.c_str(), "w");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Could not write the trace to %s\n", filename.c_str());
+        return false;
+    }
+
+    unsigned int generation = captureGeneration;
+    uint64_t origin = captureStart;
+    bool first = true;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (auto buffer : buffers)
+    {
+        const char *name = buffer->name;
+        if (name != nullptr)
+        {
+            fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"",
+                    first ? "" : ",", buffer->id);
+            writeEscaped(file, name);
+            fprintf(file, "\"}}");
+            first = false;
+        }
+
+        if (buffer->generation.load(std::memory_order_acquire) != generation)
+            continue;
+
+        unsigned int count = buffer->count.load(std::memory_order_acquire);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            const ProfileEvent &event = buffer->events[i];
+            // Timestamps are in microseconds
+            fprintf(file, "%s\n{\"name\":\"", first ? "" : ",");
+            writeEscaped(file, event.name);
+            fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", buffer->id,
+                    (int64_t)(event.start - origin) / 1000.0, (event.end - event.start) / 1000.0);
+            first = false;
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
+
+unsigned long BzfProfiler::getDroppedCount()
+{
+    unsigned int generation = captureGeneration;
+    unsigned long dropped = 0;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (auto buffer : buffers)
+        if (buffer->generation == generation)
+            dropped += buffer->dropped;
+    return dropped;
+}
+
+BzfProfileZone::BzfProfileZone(const char *_name) : name(_name), start(BzfClock::now())
+{
+}
+
+BzfProfileZone::~BzfProfileZone()
+{
+    BzfProfiler::addZone(name, start, BzfClock::now());
+}
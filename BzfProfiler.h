@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+// The events of one thread, see BzfProfiler::reserveBuffer()
+struct BzfProfileBuffer;
+
+// Records how long scoped zones of code take, for viewing as a Chrome trace (chrome://tracing or ui.perfetto.dev).
+// Zones are placed with BZF_PROFILE_ZONE("name"), which compiles to nothing unless BZF_PROFILING is defined (the
+// ENABLE_PROFILING CMake option), so they can stay in hot paths. Each thread writes into a buffer of its own without
+// taking locks. A capture runs from start() to stop(), and events past a thread's buffer capacity are dropped.
+class BzfProfiler
+{
+public:
+    // Begin a new capture, discarding the events of the previous one
+    static void start();
+    static void stop();
+    static bool isCapturing();
+
+    // Name the calling thread in the trace
+    static void setThreadName(const char *name);
+    // Make a buffer ahead of time for a thread that must not allocate, like the callback thread of an audio device.
+    // Buffers are never freed, so keep it for all the threads that take that role.
+    static BzfProfileBuffer* reserveBuffer();
+    // Record the zones of the calling thread into a buffer from reserveBuffer(), unless the thread has one already.
+    // Neither allocates nor locks, so it can be called at the start of every real-time callback.
+    static void adoptBuffer(BzfProfileBuffer *buffer);
+
+    // Write the events of the last capture as Chrome trace event JSON. Returns false if the file can not be written.
+    // Do not call start() while this runs.
+    static bool writeTrace(const std::string &filename);
+    // Number of events that did not fit into the buffers during the last capture
+    static unsigned long getDroppedCount();
+
+    // Used by BzfProfileZone. The name has to stay valid until the trace is written, so pass a string literal.
+    static void addZone(const char *name, uint64_t start, uint64_t end);
+};
+
+// Times the scope it lives in
+class BzfProfileZone
+{
+public:
+    BzfProfileZone(const char *name);
+    ~BzfProfileZone();
+
+private:
+    const char *name;
+    uint64_t start;
+};
+
+#ifdef BZF_PROFILING
+#define BZF_PROFILE_CONCAT_(a, b) a##b
+#define BZF_PROFILE_CONCAT(a, b) BZF_PROFILE_CONCAT_(a, b)
+#define BZF_PROFILE_ZONE(name) BzfProfileZone BZF_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define BZF_PROFILE_THREAD(name) BzfProfiler::setThreadName(name)
+#else
+#define BZF_PROFILE_ZONE(name) do {} while (0)
+#define BZF_PROFILE_THREAD(name) do {} while (0)
+#endif
@@ -0,0 +1,82 @@
+#include "BzfRenderThread.h"
+#include "BzfBackend.h"
+#include "BzfProfiler.h"
+
+#include <chrono>
+
+BzfRenderThread::BzfRenderThread(BzfWindow *_window, std::function<void(BzfWindow*)> _frame) : window(_window),
+    frame(_frame), running(false), frames(0)
+{
+}
+
+BzfRenderThread::~BzfRenderThread()
+{
+    stop();
+}
+
+void BzfRenderThread::start()
+{
+    if (thread.joinable())
+        return;
+
+    running = true;
+    thread = std::thread(&BzfRenderThread::run, this);
+}
+
+void BzfRenderThread::stop()
+{
+    running = false;
+    if (thread.joinable())
+        thread.join();
+}
+
+bool BzfRenderThread::isRunning() const
+{
+    return running;
+}
+
+BzfWindow* BzfRenderThread::getWindow() const
+{
+    return window;
+}
+
+unsigned long BzfRenderThread::getFrameCount() const
+{
+    return frames;
+}
+
+void BzfRenderThread::run()
+{
+    BZF_PROFILE_THREAD("render");
+#ifdef BZF_STATIC_DISPATCH
+    // Windows of the null platform are not of the backend type, and have to go through the interface
+    BzfBackendWindow* backendWindow = dynamic_cast<BzfBackendWindow*>(window);
+    if (backendWindow != nullptr)
+    {
+        renderFrames(backendWindow);
+        return;
+    }
+#endif
+    renderFrames(window);
+}
+
+template<class Window> void BzfRenderThread::renderFrames(Window *renderWindow)
+{
+    renderWindow->makeContextCurrent();
+
+    while (running)
+    {
+        // Nothing would be seen, and swapping a hidden window blocks indefinitely on some systems
+        if (renderWindow->isHidden())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(hiddenCheckInterval));
+            continue;
+        }
+
+        frame(window);
+        renderWindow->swapBuffers();
+        ++frames;
+    }
+
+    renderWindow->releaseContext();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "BzfPlatform.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+// Renders a single window from its own thread. The thread makes the window's context current, then calls the frame
+// function and swaps buffers until it is stopped, so a swap that blocks on vertical sync only holds up this window.
+// Events still have to be polled from the main thread, and the frame function must not call into the platform other
+// than through the window it is given. On macOS, Cocoa requires window changes to happen on the main thread; only the
+// context is used from the render thread, but this mode gets less testing there. Frames are skipped while the window is
+// hidden.
+class BzfRenderThread
+{
+public:
+    BzfRenderThread(BzfWindow *window, std::function<void(BzfWindow*)> frame);
+    // Stops the thread if it is still running. Has to happen before the window is destroyed.
+    ~BzfRenderThread();
+
+    // The window's context must not be current on any other thread when starting, see BzfWindow::releaseContext()
+    void start();
+    // Ask the thread to finish its current frame and wait for it. The context is released again, so that it can be
+    // made current on the calling thread afterwards.
+    void stop();
+    bool isRunning() const;
+
+    BzfWindow* getWindow() const;
+    unsigned long getFrameCount() const;
+
+private:
+    // How often to check whether a hidden window was shown again, in milliseconds
+    static const int hiddenCheckInterval = 50;
+
+    void run();
+    // The frame loop, called through the backend type when the window is one, see BzfBackend.h
+    template<class Window> void renderFrames(Window *renderWindow);
+
+    BzfWindow *window;
+    std::function<void(BzfWindow*)> frame;
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<unsigned long> frames;
+};
@@ -0,0 +1,81 @@
+#include "BzfSwapHistogram.h"
+
+BzfSwapHistogram::BzfSwapHistogram()
+{
+    clear();
+}
+
+void BzfSwapHistogram::add(double interval)
+{
+    if (interval < 0.0)
+        interval = 0.0;
+
+    // Forget the oldest interval once the history is full
+    if (count == historySize)
+    {
+        --buckets[bucketFor(history[next])];
+        sum -= history[next];
+    }
+    else
+        ++count;
+
+    history[next] = interval;
+    next = (next + 1) % historySize;
+    sum += interval;
+    ++buckets[bucketFor(interval)];
+}
+
+void BzfSwapHistogram::clear()
+{
+    next = 0;
+    count = 0;
+    sum = 0.0;
+    for (int i = 0; i < bucketCount; ++i)
+        buckets[i] = 0;
+}
+
+int BzfSwapHistogram::getCount() const
+{
+    return count;
+}
+
+int BzfSwapHistogram::getBucket(int bucket) const
+{
+    if (bucket < 0 || bucket >= bucketCount)
+        return 0;
+    return buckets[bucket];
+}
+
+double BzfSwapHistogram::getMean() const
+{
+    return count > 0 ? sum / count : 0.0;
+}
+
+double BzfSwapHistogram::getPercentile(double fraction) const
+{
+    int wanted = (int)(fraction * count + 0.5);
+    int seen = 0;
+    for (int i = 0; i < bucketCount; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= wanted && seen > 0)
+            return (i + 1) * 0.001;
+    }
+    return 0.0;
+}
+
+int BzfSwapHistogram::getMissedCount(double deadline) const
+{
+    double limit = deadline * 1.5;
+    int missed = 0;
+    for (int i = 0; i < count; ++i)
+        if (history[i] > limit)
+            ++missed;
+    return missed;
+}
+
+int BzfSwapHistogram::bucketFor(double interval)
+{
+    int bucket = (int)(interval * 1000.0);
+    return bucket < bucketCount ? bucket : bucketCount - 1;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// A histogram of the time between the most recent buffer swaps of a window. Only the last historySize intervals are
+// counted, so it follows changes of the swap policy or the load within a few seconds.
+class BzfSwapHistogram
+{
+public:
+    static const int historySize = 240;
+    // Buckets are a millisecond wide, and the last one collects everything longer
+    static const int bucketCount = 51;
+
+    BzfSwapHistogram();
+
+    // Add a swap interval, in seconds
+    void add(double interval);
+    void clear();
+
+    int getCount() const;
+    int getBucket(int bucket) const;
+    double getMean() const;
+    // Smallest interval that the given fraction of the intervals does not exceed, to the resolution of a bucket
+    double getPercentile(double fraction) const;
+    // Number of intervals that took longer than the deadline (in seconds) by at least half a refresh
+    int getMissedCount(double deadline) const;
+
+private:
+    static int bucketFor(double interval);
+
+    double history[historySize];
+    int next;
+    int count;
+    double sum;
+    int buckets[bucketCount];
+};
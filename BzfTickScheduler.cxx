@@ -0,0 +1,126 @@
+#include "BzfTickScheduler.h"
+#include "BzfPlatform.h"
+
+#include <cmath>
+
+BzfTickScheduler::BzfTickScheduler(BzfPlatform *_platform, double ticksPerSecond, int _maxTicksPerFrame) :
+    platform(_platform), tickInterval(BzfClock::ticksPerSecond / 60), maxTicksPerFrame(1), lastUpdate(0), started(false),
+    accumulator(0), tickCount(0)
+{
+    setTickRate(ticksPerSecond);
+    setMaxTicksPerFrame(_maxTicksPerFrame);
+    resetStatistics();
+}
+
+void BzfTickScheduler::setTickRate(double ticksPerSecond)
+{
+    if (ticksPerSecond > 0.0)
+        tickInterval = BzfClock::fromSeconds(1.0 / ticksPerSecond);
+}
+
+double BzfTickScheduler::getTickRate() const
+{
+    return 1.0 / BzfClock::toSeconds(tickInterval);
+}
+
+double BzfTickScheduler::getTickInterval() const
+{
+    return BzfClock::toSeconds(tickInterval);
+}
+
+void BzfTickScheduler::setMaxTicksPerFrame(int maxTicks)
+{
+    maxTicksPerFrame = maxTicks > 0 ? maxTicks : 1;
+}
+
+int BzfTickScheduler::getMaxTicksPerFrame() const
+{
+    return maxTicksPerFrame;
+}
+
+int BzfTickScheduler::update(std::function<void(unsigned long tick, double interval)> tick)
+{
+    uint64_t now = platform->getGameTicks();
+    if (!started)
+    {
+        lastUpdate = now;
+        started = true;
+    }
+    accumulator += now - lastUpdate;
+    lastUpdate = now;
+
+    int ticks = 0;
+    while (accumulator >= tickInterval)
+    {
+        if (ticks == maxTicksPerFrame)
+        {
+            // Drop the whole ticks that are left, but keep the fraction so alpha stays continuous
+            uint64_t dropped = accumulator / tickInterval;
+            droppedTicks += dropped;
+            accumulator -= dropped * tickInterval;
+            break;
+        }
+
+        uint64_t start = platform->getGameTicks();
+        tick(tickCount, BzfClock::toSeconds(tickInterval));
+        double duration = BzfClock::toSeconds(platform->getGameTicks() - start);
+
+        ++tickCount;
+        ++ticks;
+        accumulator -= tickInterval;
+
+        ++measuredTicks;
+        double delta = duration - tickDurationMean;
+        tickDurationMean += delta / measuredTicks;
+        tickDurationM2 += delta * (duration - tickDurationMean);
+        if (duration > tickDurationMax)
+            tickDurationMax = duration;
+    }
+
+    return ticks;
+}
+
+double BzfTickScheduler::getAlpha() const
+{
+    return (double)accumulator / tickInterval;
+}
+
+void BzfTickScheduler::reset()
+{
+    started = false;
+    accumulator = 0;
+}
+
+unsigned long BzfTickScheduler::getTickCount() const
+{
+    return tickCount;
+}
+
+unsigned long BzfTickScheduler::getDroppedTickCount() const
+{
+    return droppedTicks;
+}
+
+double BzfTickScheduler::getTickDurationMean() const
+{
+    return tickDurationMean;
+}
+
+double BzfTickScheduler::getTickDurationStdDev() const
+{
+    return measuredTicks > 1 ? sqrt(tickDurationM2 / (measuredTicks - 1)) : 0.0;
+}
+
+double BzfTickScheduler::getTickDurationMax() const
+{
+    return tickDurationMax;
+}
+
+void BzfTickScheduler::resetStatistics()
+{
+    droppedTicks = 0;
+    measuredTicks = 0;
+    tickDurationMean = 0.0;
+    tickDurationM2 = 0.0;
+    tickDurationMax = 0.0;
+}
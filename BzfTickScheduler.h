@@ -0,0 +1,57 @@
+#pragma once
+
+#include <functional>
+#include <stdint.h>
+
+class BzfPlatform;
+
+// Runs the simulation in ticks of a fixed length, independent of how fast frames are drawn. The time since the last
+// update goes into an accumulator, and as many ticks are run as fit in it. When a frame took so long that more than
+// maxTicksPerFrame would be due, the rest is dropped rather than caught up on, since running ticks would make the next
+// frame even later. Whatever is left in the accumulator gives the alpha to interpolate between the last two tick states.
+class BzfTickScheduler
+{
+public:
+    BzfTickScheduler(BzfPlatform *platform, double ticksPerSecond = 60.0, int maxTicksPerFrame = 5);
+
+    void setTickRate(double ticksPerSecond);
+    double getTickRate() const;
+    // Length of a tick in seconds
+    double getTickInterval() const;
+    void setMaxTicksPerFrame(int maxTicks);
+    int getMaxTicksPerFrame() const;
+
+    // Call once per frame. Runs the tick function for every tick that is due, passing the tick number and the tick
+    // interval, and returns how many ticks were run.
+    int update(std::function<void(unsigned long tick, double interval)> tick);
+    // How far into the next tick the current time is, from 0 to 1
+    double getAlpha() const;
+    // Start over from the current time with an empty accumulator, for instance after loading
+    void reset();
+
+    // Statistics
+    unsigned long getTickCount() const;
+    // Ticks that were due but dropped because too many were due in one frame
+    unsigned long getDroppedTickCount() const;
+    // Time spent running a tick function, in seconds
+    double getTickDurationMean() const;
+    double getTickDurationStdDev() const;
+    double getTickDurationMax() const;
+    void resetStatistics();
+
+private:
+    BzfPlatform *platform;
+    // Kept in game ticks, so the accumulator does not pick up rounding errors over time
+    uint64_t tickInterval;
+    int maxTicksPerFrame;
+    uint64_t lastUpdate;
+    bool started;
+    uint64_t accumulator;
+    unsigned long tickCount;
+
+    unsigned long droppedTicks;
+    unsigned long measuredTicks;
+    double tickDurationMean;
+    double tickDurationM2;
+    double tickDurationMax;
+};
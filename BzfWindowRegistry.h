@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+class BzfWindow;
+
+// Finds our window for the ID a window system gives its windows (like SDL's window IDs). Event routing does this for
+// every event, so the windows are kept in a small table that is scanned, which for the few windows a game has costs no
+// more than a couple of compares. IDs are not used as indexes, as SDL never reuses them and the table would grow with
+// every window ever made. A removed window's slot is taken by the next one instead, so the table only ever holds as
+// many slots as there were windows at the same time.
+class BzfWindowRegistry
+{
+public:
+    void add(unsigned int id, BzfWindow *window)
+    {
+        Slot *freeSlot = nullptr;
+        for (auto &slot : table)
+        {
+            if (slot.window != nullptr && slot.id == id)
+            {
+                slot.window = window;
+                return;
+            }
+            if (slot.window == nullptr && freeSlot == nullptr)
+                freeSlot = &slot;
+        }
+        if (freeSlot != nullptr)
+            *freeSlot = Slot{id, window};
+        else
+            table.push_back(Slot{id, window});
+    }
+    void remove(unsigned int id)
+    {
+        for (auto &slot : table)
+        {
+            if (slot.window != nullptr && slot.id == id)
+                slot.window = nullptr;
+        }
+    }
+    // nullptr for an ID that is unknown, or whose window was destroyed
+    BzfWindow* get(unsigned int id) const
+    {
+        for (const auto &slot : table)
+        {
+            if (slot.window != nullptr && slot.id == id)
+                return slot.window;
+        }
+        return nullptr;
+    }
+
+private:
+    struct Slot
+    {
+        unsigned int id;
+        BzfWindow *window;
+    };
+
+    std::vector<Slot> table;
+};
@@ -0,0 +1,74 @@
+#include "GLDebugOutput.h"
+#include "BzfMetrics.h"
+
+#include <stdio.h>
+
+static const char* typeName(GLenum type)
+{
+    switch(type)
+    {
+    // *INDENT-OFF*
+    case GL_DEBUG_TYPE_ERROR: return "error";
+    case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+    case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+    case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+    case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+    default: return "other";
+    // *INDENT-ON*
+    }
+}
+
+static const char* severityName(GLenum severity)
+{
+    switch(severity)
+    {
+    // *INDENT-OFF*
+    case GL_DEBUG_SEVERITY_HIGH: return "high";
+    case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+    case GL_DEBUG_SEVERITY_LOW: return "low";
+    default: return "notification";
+    // *INDENT-ON*
+    }
+}
+
+bool GLDebugOutput::enable(const BzfGLCapabilities &capabilities)
+{
+    // Part of OpenGL 4.3, otherwise it takes the extension
+    if (!capabilities.debugOutput)
+        return false;
+
+    glEnable(GL_DEBUG_OUTPUT);
+    // Report each message from within the call that caused it, so that a breakpoint in the callback shows the culprit
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(callback, nullptr);
+    return true;
+}
+
+void GLDebugOutput::disable(const BzfGLCapabilities &capabilities)
+{
+    if (!capabilities.debugOutput)
+        return;
+
+    glDebugMessageCallback(nullptr, nullptr);
+    glDisable(GL_DEBUG_OUTPUT);
+}
+
+void GLAPIENTRY GLDebugOutput::callback(GLenum /*source*/, GLenum type, GLuint id, GLenum severity, GLsizei /*length*/,
+                                        const GLchar *message, const void* /*userParam*/)
+{
+    static BzfCounter *messages = BzfMetrics::get().counter("gl.debug.messages");
+    static BzfCounter *errors = BzfMetrics::get().counter("gl.debug.errors");
+    static BzfCounter *performance = BzfMetrics::get().counter("gl.debug.performance");
+
+    messages->add();
+    if (type == GL_DEBUG_TYPE_ERROR)
+        errors->add();
+    else if (type == GL_DEBUG_TYPE_PERFORMANCE)
+        performance->add();
+
+    // Some drivers send a notification for every buffer they allocate
+    if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+        return;
+
+    fprintf(stderr, "GL %s (%s severity, %u): %s\n", typeName(type), severityName(severity), id, message);
+}
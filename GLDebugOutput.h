@@ -0,0 +1,20 @@
+#pragma once
+
+#include "BzfGL.h"
+
+// Passes the messages of the driver's debug output (KHR_debug) on to stderr and the metrics. Messages are counted in
+// "gl.debug.messages", with errors and performance warnings (like a draw that had to recompile a shader or stall on a
+// buffer) counted separately as well. Mere notifications are only counted. Drivers say most in a context created with
+// BZF_GL_CONTEXT_DEBUG.
+class GLDebugOutput
+{
+public:
+    // Start receiving the messages of the current context, whose capabilities are given. Returns false if the driver
+    // has no debug output.
+    static bool enable(const BzfGLCapabilities &capabilities);
+    static void disable(const BzfGLCapabilities &capabilities);
+
+private:
+    static void GLAPIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                    const GLchar *message, const void *userParam);
+};
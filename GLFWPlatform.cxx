@@ -1,25 +1,41 @@
 #include "GLFWPlatform.h"
+#include "BzfMetrics.h"
+#include "BzfProfiler.h"
 #include <stdio.h>
 #include <iostream>
 #include <string.h>
+#include <algorithm>
+#include <mutex>
 
 ///////////////////////////////////////////////////////////
 // Platform
 ///////////////////////////////////////////////////////////
 
-GLFWPlatform *GLFWPlatform::platform = nullptr;
+// GLFW is set up once for all the platforms of the process, and shut down with the last of them
+static std::mutex initMutex;
+static int initCount = 0;
 
 GLFWPlatform::GLFWPlatform() : joystick(nullptr), inTextInputMode(false)
 {
+    {
+        std::lock_guard<std::mutex> lock(initMutex);
+        if (initCount == 0)
+        {
 #if (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 3) || GLFW_VERSION_MAJOR > 3
-    // Do not include the joystick hats as buttons
-    glfwInitHint(GLFW_JOYSTICK_HAT_BUTTONS, GLFW_FALSE);
+            // Do not include the joystick hats as buttons
+            glfwInitHint(GLFW_JOYSTICK_HAT_BUTTONS, GLFW_FALSE);
 #endif
 
-    if (!glfwInit())
-    {
-        std::cerr << "Error: There was an error initializing GLFW." << std::endl;
-        exit(-1);
+            if (!glfwInit())
+            {
+                std::cerr << "Error: There was an error initializing GLFW." << std::endl;
+                exit(-1);
+            }
+
+            // Error callback
+            glfwSetErrorCallback(GLFWPlatform::error_callback);
+        }
+        ++initCount;
     }
 
     int i;
@@ -30,48 +46,61 @@ GLFWPlatform::GLFWPlatform() : joystick(nullptr), inTextInputMode(false)
         joystickHatDirection[i] = BZF_JOY_HAT_CENTERED;
 #endif
 
-    // Store a static pointer to ourself, for use in callbacks
-    GLFWPlatform::platform = this;
+    // Events are routed to the platform through the user pointer of each window, see GLFWWindow::getPlatform()
 #if (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 3) || GLFW_VERSION_MAJOR > 3
     // Use full resolution framebuffers on Retina displays
     glfwWindowHint(GLFW_COCOA_RETINA_FRAMEBUFFER, GLFW_TRUE);
     // Use the discrete graphics card on systems with hybrid graphics
     glfwWindowHint(GLFW_COCOA_GRAPHICS_SWITCHING, GLFW_FALSE);
 #endif
-
-    // Error callback
-    glfwSetErrorCallback(GLFWPlatform::error_callback);
-
-#ifdef _DEBUG
-	// For debugging, set the start time of the program to be 184 days in the past to catch issues that may occur with long running programs
-	glfwSetTime(60.0 * 60.0 * 24.0 * 184.0);
-#endif
 }
 
 GLFWPlatform::~GLFWPlatform()
 {
+    shutdownJobSystem();
+
     // Delete all the windows (Is this necessary?)
     for (auto window : windows)
         delete window;
+    BzfMetrics::get().gauge("windows")->add(-(double)windows.size());
 
-    // Shut down GLFW
-    glfwTerminate();
+    // Shut down GLFW once no other platform uses it
+    std::lock_guard<std::mutex> lock(initMutex);
+    if (--initCount == 0)
+        glfwTerminate();
 }
 
 BzfWindow* GLFWPlatform::createWindow(int width, int height, BzfMonitor* monitor, int positionX, int positionY)
 {
-    GLFWWindow* window = new GLFWWindow(this, width, height, static_cast<GLFWMonitor*>(monitor), positionX, positionY);
+    GLFWWindow* shareWith = (GLGetSharedContexts() && !windows.empty()) ? windows.front() : nullptr;
+    GLFWWindow* window = new GLFWWindow(this, width, height, static_cast<GLFWMonitor*>(monitor), positionX, positionY,
+                                        shareWith);
     windows.push_back(window);
+    BzfMetrics::get().gauge("windows")->add(1);
     return window;
 }
 
 BzfWindow* GLFWPlatform::createWindow(BzfResolution resolution, BzfMonitor *monitor)
 {
-    GLFWWindow* window = new GLFWWindow(this, resolution, static_cast<GLFWMonitor*>(monitor));
+    GLFWWindow* shareWith = (GLGetSharedContexts() && !windows.empty()) ? windows.front() : nullptr;
+    GLFWWindow* window = new GLFWWindow(this, resolution, static_cast<GLFWMonitor*>(monitor), shareWith);
     windows.push_back(window);
+    BzfMetrics::get().gauge("windows")->add(1);
     return window;
 }
 
+void GLFWPlatform::destroyWindow(BzfWindow* window)
+{
+    // Events are routed through the user pointer of the GLFW window, which goes away with it
+    auto found = std::find(windows.begin(), windows.end(), window);
+    if (found == windows.end())
+        return;
+
+    windows.erase(found);
+    delete window;
+    BzfMetrics::get().gauge("windows")->add(-1);
+}
+
 BzfAudio *GLFWPlatform::getAudio()
 {
     return nullptr;
@@ -97,11 +126,6 @@ bool GLFWPlatform::isGameRunning() const
     return true;
 }
 
-double GLFWPlatform::getGameTime() const
-{
-    return glfwGetTime();
-}
-
 BzfMonitor* GLFWPlatform::getPrimaryMonitor() const
 {
     GLFWMonitor* monitor = new GLFWMonitor;
@@ -180,6 +204,19 @@ void GLFWPlatform::GLSetVersion(BzfGLProfile profile, unsigned short majorVersio
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minorVersion);
 }
 
+void GLFWPlatform::GLSetContextFlags(int flags) const
+{
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, (flags & BZF_GL_CONTEXT_DEBUG) ? GLFW_TRUE : GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_ROBUSTNESS,
+                   (flags & BZF_GL_CONTEXT_ROBUST) ? GLFW_LOSE_CONTEXT_ON_RESET : GLFW_NO_ROBUSTNESS);
+#if (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 2) || GLFW_VERSION_MAJOR > 3
+    // GLFW leaves this out by itself where the driver does not support it. A debug context that does not report errors
+    // would be pointless.
+    glfwWindowHint(GLFW_CONTEXT_NO_ERROR, ((flags & BZF_GL_CONTEXT_NO_ERROR) && !(flags & BZF_GL_CONTEXT_DEBUG)) ?
+                   GLFW_TRUE : GLFW_FALSE);
+#endif
+}
+
 void GLFWPlatform::GLSetRGBA(unsigned short red, unsigned short green, unsigned short blue,
                              unsigned short /*alpha*/) const
 {
@@ -188,7 +225,46 @@ void GLFWPlatform::GLSetRGBA(unsigned short red, unsigned short green, unsigned
     glfwWindowHint(GLFW_BLUE_BITS, blue);
 }
 
+// GLFW hands events straight to the callbacks, so they are counted there
+static void countEvent()
+{
+    static BzfCounter *events = BzfMetrics::get().counter("events");
+    events->add();
+}
+
+// Tag input for a window with the time it arrived, for latency measurement. GLFW events carry no timestamp, but they
+// are handed out as soon as glfwPollEvents() reads them.
+static void markInput(GLFWWindow* window)
+{
+    if (window->getLatencyTracker().isEnabled())
+        window->getLatencyTracker().inputArrived(BzfClock::now());
+}
+
 void GLFWPlatform::pollEvents()
+{
+    BZF_PROFILE_ZONE("GLFWPlatform::pollEvents");
+    pollJoystick();
+    glfwPollEvents();
+}
+
+void GLFWPlatform::waitEvents(double timeout)
+{
+    BZF_PROFILE_ZONE("GLFWPlatform::waitEvents");
+    // Joystick input does not wake this up, so it is only noticed once the wait is over
+    glfwWaitEventsTimeout(timeout);
+    pollJoystick();
+}
+
+bool GLFWPlatform::hasVisibleWindow() const
+{
+    for (auto window : windows)
+        if (!window->isHidden())
+            return true;
+
+    return false;
+}
+
+void GLFWPlatform::pollJoystick()
 {
     // GLFW does not currently have an event system for joysticks, so you have to poll for the button state. This will
     // likely miss events, especially if this function is not called frequenly, such as if the main thread also
@@ -203,6 +279,7 @@ void GLFWPlatform::pollEvents()
 
         if (glfwJoystickPresent(joystickID))
         {
+            BZF_PROFILE_ZONE("joystickCallbacks");
             int count, i;
             if (joystickButtonCallback != nullptr)
             {
@@ -254,9 +331,15 @@ void GLFWPlatform::pollEvents()
                         continue;
 
                     if (!joystickButtonPressed[i] && buttons[i] == GLFW_PRESS)
+                    {
+                        countEvent();
                         joystickButtonCallback(this, windows.at(0), button, BZF_BUTTON_PRESSED);
+                    }
                     else if (joystickButtonPressed[i] && buttons[i] != GLFW_PRESS)
+                    {
+                        countEvent();
                         joystickButtonCallback(this, windows.at(0), button, BZF_BUTTON_RELEASED);
+                    }
 
                     joystickButtonPressed[i] = (buttons[i] == GLFW_PRESS);
                 }
@@ -306,7 +389,10 @@ void GLFWPlatform::pollEvents()
 
                     // Trigger the callback if
                     if (joystickHatDirection[i] != direction)
+                    {
+                        countEvent();
                         joystickHatCallback(this, windows.at(0), hat, direction);
+                    }
 
                     joystickHatDirection[i] = direction;
                 }
@@ -314,24 +400,43 @@ void GLFWPlatform::pollEvents()
 #endif
         }
     }
-
-    glfwPollEvents();
 }
 
 void GLFWPlatform::callResizeCallback(GLFWwindow* window, int width, int height)
 {
+    BZF_PROFILE_ZONE("resizeCallback");
+    countEvent();
+    GLFWWindow* bzwindow = static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window));
+    if (bzwindow == nullptr)
+        return;
+    // Before the callbacks, so that they see the new size
+    bzwindow->refreshState();
+    GLFWPlatform* platform = bzwindow->getPlatform();
     for (auto callback : platform->resizeCallbacks)
-        callback(platform, static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window)), width, height);
+        callback(platform, bzwindow, width, height);
 }
 
 void GLFWPlatform::callMoveCallback(GLFWwindow* window, int xpos, int ypos)
 {
+    BZF_PROFILE_ZONE("moveCallback");
+    countEvent();
+    GLFWWindow* bzwindow = static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window));
+    if (bzwindow == nullptr)
+        return;
+    bzwindow->refreshState();
+    GLFWPlatform* platform = bzwindow->getPlatform();
     for (auto callback : platform->moveCallbacks)
-        callback(platform, static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window)), xpos, ypos);
+        callback(platform, bzwindow, xpos, ypos);
 }
 
 void GLFWPlatform::callKeyCallback(GLFWwindow* window, int key, int /*scancode*/, int action, int mods)
 {
+    BZF_PROFILE_ZONE("keyCallback");
+    countEvent();
+    GLFWWindow* bzwindow = static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window));
+    if (bzwindow == nullptr)
+        return;
+    GLFWPlatform* platform = bzwindow->getPlatform();
     if (platform->keyCallback != nullptr)
     {
         BzfKeyAction kaction = BZF_KEY_RELEASED;
@@ -340,8 +445,8 @@ void GLFWPlatform::callKeyCallback(GLFWwindow* window, int key, int /*scancode*/
         else if (action == GLFW_REPEAT)
             kaction = BZF_KEY_REPEATED;
 
-        platform->keyCallback(platform, static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window)), keyFromGLFW(key), kaction,
-                              modsFromGLFW(mods));
+        markInput(bzwindow);
+        platform->keyCallback(platform, bzwindow, keyFromGLFW(key), kaction, modsFromGLFW(mods));
     }
 }
 
@@ -492,25 +597,47 @@ void append_unicode(char *string, nk_rune unicode2, unsigned int maxSize)
 
 void GLFWPlatform::callTextCallback(GLFWwindow* window, unsigned int codepoint)
 {
+    BZF_PROFILE_ZONE("textCallback");
+    countEvent();
+    GLFWWindow* bzwindow = static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window));
+    if (bzwindow == nullptr)
+        return;
+    GLFWPlatform* platform = bzwindow->getPlatform();
     if (platform->textCallback != nullptr)
     {
         char buffer[32] = {0};
 
         append_unicode(buffer, codepoint, 32);
 
-        platform->textCallback(platform, static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window)), buffer);
+        markInput(bzwindow);
+        platform->textCallback(platform, bzwindow, buffer);
     }
 
 }
 
 void GLFWPlatform::callCursorPosCallback(GLFWwindow* window, double xpos, double ypos)
 {
+    BZF_PROFILE_ZONE("cursorPosCallback");
+    countEvent();
+    GLFWWindow* bzwindow = static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window));
+    if (bzwindow == nullptr)
+        return;
+    GLFWPlatform* platform = bzwindow->getPlatform();
     if (platform->cursorPosCallback != nullptr)
-        platform->cursorPosCallback(platform, static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window)), xpos, ypos);
+    {
+        markInput(bzwindow);
+        platform->cursorPosCallback(platform, bzwindow, xpos, ypos);
+    }
 }
 
 void GLFWPlatform::callMouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
+    BZF_PROFILE_ZONE("mouseButtonCallback");
+    countEvent();
+    GLFWWindow* bzwindow = static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window));
+    if (bzwindow == nullptr)
+        return;
+    GLFWPlatform* platform = bzwindow->getPlatform();
     if (platform->mouseButtonCallback != nullptr)
     {
         BzfMouseButton bzbutton;
@@ -531,15 +658,25 @@ void GLFWPlatform::callMouseButtonCallback(GLFWwindow* window, int button, int a
         }
         if (bzbutton == BZF_MOUSE_UNKNOWN)
             return;
-        platform->mouseButtonCallback(platform, static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window)), bzbutton,
+        markInput(bzwindow);
+        platform->mouseButtonCallback(platform, bzwindow, bzbutton,
                                       (action == GLFW_PRESS)?BZF_BUTTON_PRESSED:BZF_BUTTON_RELEASED, modsFromGLFW(mods));
     }
 }
 
 void GLFWPlatform::callScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
 {
+    BZF_PROFILE_ZONE("scrollCallback");
+    countEvent();
+    GLFWWindow* bzwindow = static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window));
+    if (bzwindow == nullptr)
+        return;
+    GLFWPlatform* platform = bzwindow->getPlatform();
     if (platform->scrollCallback != nullptr)
-        platform->scrollCallback(platform, static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window)), xoffset, yoffset);
+    {
+        markInput(bzwindow);
+        platform->scrollCallback(platform, bzwindow, xoffset, yoffset);
+    }
 }
 
 void GLFWPlatform::startTextInput()
@@ -827,11 +964,15 @@ void GLFWPlatform::error_callback(int error, const char* description)
 // Window
 ///////////////////////////////////////////////////////////
 
+// The contextId of the window whose context is current on this thread, so that redundant switches can be skipped
+static thread_local uint64_t currentContext = 0;
+
 GLFWWindow::GLFWWindow(GLFWPlatform *_platform, int width, int height, GLFWMonitor* _monitor, int positionX,
-                       int positionY) : platform(_platform), fullscreen(false), gamma(1.0f)
+                       int positionY, GLFWWindow* shareWith) : platform(_platform), gamma(1.0f)
 {
     // Create the window
-    window = glfwCreateWindow(width, height, "GLFWWindow", nullptr, nullptr);
+    window = glfwCreateWindow(width, height, "GLFWWindow", nullptr,
+                              shareWith != nullptr ? shareWith->window : nullptr);
 
     // Check if this worked
     if (!window)
@@ -863,12 +1004,13 @@ GLFWWindow::GLFWWindow(GLFWPlatform *_platform, int width, int height, GLFWMonit
 
     glfwSetWindowPos(window, positionX, positionY);
 
+    loadContext();
     glfwSetWindowUserPointer(window, this);
     assignCallbacks();
 }
 
-GLFWWindow::GLFWWindow(GLFWPlatform *_platform, BzfResolution resolution, GLFWMonitor *_monitor) : platform(_platform),
-    fullscreen(true), gamma(1.0f)
+GLFWWindow::GLFWWindow(GLFWPlatform *_platform, BzfResolution resolution, GLFWMonitor *_monitor,
+                       GLFWWindow* shareWith) : platform(_platform), gamma(1.0f)
 {
     // Refresh rate
     // TODO: Check on the special values for this
@@ -882,8 +1024,8 @@ GLFWWindow::GLFWWindow(GLFWPlatform *_platform, BzfResolution resolution, GLFWMo
         mon = _monitor->monitor;
 
     // Make fullscreen window
-    fullscreen = true;
-    window = glfwCreateWindow(resolution.width, resolution.height, "GLFWWindow", mon, nullptr);
+    window = glfwCreateWindow(resolution.width, resolution.height, "GLFWWindow", mon,
+                              shareWith != nullptr ? shareWith->window : nullptr);
 
     if (!window)
     {
@@ -891,30 +1033,57 @@ GLFWWindow::GLFWWindow(GLFWPlatform *_platform, BzfResolution resolution, GLFWMo
         exit(-1);
     }
 
+    loadContext();
     glfwSetWindowUserPointer(window, this);
     assignCallbacks();
 }
 
-GLFWWindow::~GLFWWindow()
+// glfwGetProcAddress() only differs in its return type
+static void* getProcAddress(const char *name)
 {
-    glfwDestroyWindow(window);
+    return (void*)glfwGetProcAddress(name);
 }
 
-bool GLFWWindow::isFullscreen() const
+void GLFWWindow::loadContext()
 {
-    return fullscreen;
+    makeContextCurrent();
+    if (!loadGLFunctions(getProcAddress, glCapabilities))
+    {
+        std::cerr << "Error: Unable to load the OpenGL functions." << std::endl;
+        exit(-1);
+    }
 }
 
-bool GLFWWindow::setVerticalSync(bool sync) const
+GLFWWindow::~GLFWWindow()
 {
-    glfwSwapInterval(sync?1:0);
-    return true;
+    // Destroying the window also releases its context if it is current
+    if (currentContext == contextId)
+        currentContext = 0;
+    glfwDestroyWindow(window);
 }
 
-bool GLFWWindow::getWindowSize(int &width, int &height) const
+BzfSwapPolicy GLFWWindow::setSwapPolicy(BzfSwapPolicy policy) const
 {
-    glfwGetWindowSize(window, &width, &height);
-    return true;
+    // GLFW can not tell whether an interval was accepted, so check for the extension that adaptive sync (a negative
+    // interval) needs, and otherwise assume the driver honors the request
+    if (policy == BZF_SWAP_ADAPTIVE && !glfwExtensionSupported("WGL_EXT_swap_control_tear")
+            && !glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+    {
+        printf("Adaptive sync is not supported, using regular vertical sync\n");
+        policy = BZF_SWAP_ON;
+    }
+
+    glfwSwapInterval(swapIntervalFor(policy));
+    swapPolicy = policy;
+
+    GLFWmonitor *mon = glfwGetWindowMonitor(window);
+    if (mon == nullptr)
+        mon = glfwGetPrimaryMonitor();
+    const GLFWvidmode *vmode = mon != nullptr ? glfwGetVideoMode(mon) : nullptr;
+    if (vmode != nullptr && vmode->refreshRate > 0)
+        refreshInterval = 1.0 / vmode->refreshRate;
+
+    return swapPolicy;
 }
 
 bool GLFWWindow::setWindowed(int width, int height, BzfMonitor* _monitor, int x, int y)
@@ -941,17 +1110,17 @@ bool GLFWWindow::setWindowed(int width, int height, BzfMonitor* _monitor, int x,
         y += yOffset;
 
     // Switch to windowed mode
-    fullscreen = false;
     glfwSetWindowMonitor(window, nullptr, x, y, width, height, GLFW_DONT_CARE);
+    refreshState();
 
     return true;
 }
 
 bool GLFWWindow::setFullscreen(BzfResolution resolution, BzfMonitor *monitor)
 {
-    fullscreen = true;
     glfwSetWindowMonitor(window, static_cast<GLFWMonitor*>(monitor)->monitor, 0, 0, resolution.width, resolution.height,
                          resolution.refreshRate);
+    refreshState();
     // Set the gamma, since we can't apply it while windowed
     setGamma(getGamma());
     return true;
@@ -1009,12 +1178,28 @@ BzfMouseConfinement GLFWWindow::getConfineMouse()
 
 void GLFWWindow::makeContextCurrent() const
 {
+    if (currentContext == contextId)
+        return;
+
     glfwMakeContextCurrent(window);
+    currentContext = contextId;
+    ++contextSwitches;
+}
+
+void GLFWWindow::releaseContext() const
+{
+    if (currentContext != contextId)
+        return;
+
+    glfwMakeContextCurrent(nullptr);
+    currentContext = 0;
 }
 
 void GLFWWindow::swapBuffers() const
 {
+    BZF_PROFILE_ZONE("GLFWWindow::swapBuffers");
     glfwSwapBuffers(window);
+    recordSwap();
 }
 
 void GLFWWindow::setGamma(float _gamma)
@@ -1067,6 +1252,95 @@ void GLFWWindow::assignCallbacks()
     glfwSetScrollCallback(window, GLFWPlatform::callScrollCallback);
     glfwSetFramebufferSizeCallback(window, GLFWPlatform::callResizeCallback);
     glfwSetWindowPosCallback(window, GLFWPlatform::callMoveCallback);
+    glfwSetWindowSizeCallback(window, GLFWWindow::sizeCallback);
+    glfwSetWindowIconifyCallback(window, GLFWWindow::iconifyCallback);
+    glfwSetWindowFocusCallback(window, GLFWWindow::focusCallback);
+
+    refreshState();
+}
+
+void GLFWWindow::refreshState()
+{
+    setState(queryState());
+}
+
+BzfWindowState GLFWWindow::queryState() const
+{
+    BzfWindowState newState;
+    glfwGetWindowSize(window, &newState.width, &newState.height);
+    // This is larger than the window size on HiDPI displays
+    glfwGetFramebufferSize(window, &newState.drawableWidth, &newState.drawableHeight);
+    glfwGetWindowPos(window, &newState.x, &newState.y);
+
+    GLFWmonitor *fullscreenMonitor = glfwGetWindowMonitor(window);
+    newState.fullscreen = fullscreenMonitor != nullptr;
+    newState.focused = glfwGetWindowAttrib(window, GLFW_FOCUSED) == GLFW_TRUE;
+    newState.minimized = glfwGetWindowAttrib(window, GLFW_ICONIFIED) == GLFW_TRUE;
+    newState.hidden = glfwGetWindowAttrib(window, GLFW_VISIBLE) != GLFW_TRUE;
+
+    // A windowed window is on the monitor that has its center
+    int centerX = newState.x + newState.width / 2;
+    int centerY = newState.y + newState.height / 2;
+    newState.displayIndex = 0;
+    int count;
+    GLFWmonitor** glfwMonitors = glfwGetMonitors(&count);
+    for (int i = 0; i < count; i++)
+    {
+        if (fullscreenMonitor != nullptr)
+        {
+            if (glfwMonitors[i] == fullscreenMonitor)
+            {
+                newState.displayIndex = i;
+                break;
+            }
+            continue;
+        }
+
+        int monitorX, monitorY;
+        glfwGetMonitorPos(glfwMonitors[i], &monitorX, &monitorY);
+        const GLFWvidmode *vmode = glfwGetVideoMode(glfwMonitors[i]);
+        if (vmode != nullptr && centerX >= monitorX && centerX < monitorX + vmode->width && centerY >= monitorY
+                && centerY < monitorY + vmode->height)
+        {
+            newState.displayIndex = i;
+            break;
+        }
+    }
+
+    return newState;
+}
+
+void GLFWWindow::sizeCallback(GLFWwindow* window, int /*width*/, int /*height*/)
+{
+    countEvent();
+    GLFWWindow* bzwindow = static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window));
+    if (bzwindow != nullptr)
+        bzwindow->refreshState();
+}
+
+void GLFWWindow::iconifyCallback(GLFWwindow* window, int iconified)
+{
+    countEvent();
+    GLFWWindow* bzwindow = static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window));
+    if (bzwindow != nullptr)
+    {
+        // The attribute can lag behind the event on some window managers
+        BzfWindowState newState = bzwindow->queryState();
+        newState.minimized = (iconified == GLFW_TRUE);
+        bzwindow->setState(newState);
+    }
+}
+
+void GLFWWindow::focusCallback(GLFWwindow* window, int focused)
+{
+    countEvent();
+    GLFWWindow* bzwindow = static_cast<GLFWWindow*>(glfwGetWindowUserPointer(window));
+    if (bzwindow != nullptr)
+    {
+        BzfWindowState newState = bzwindow->queryState();
+        newState.focused = (focused == GLFW_TRUE);
+        bzwindow->setState(newState);
+    }
 }
 
 
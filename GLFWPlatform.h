@@ -2,7 +2,8 @@
 
 #include "BzfPlatform.h"
 
-#include <GL/glew.h>
+#include "BzfGL.h"
+#define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
 #include <vector>
@@ -15,7 +16,7 @@ struct GLFWMonitor : public BzfMonitor
 class GLFWWindow;
 class GLFWJoystick;
 
-class GLFWPlatform : public BzfPlatform
+class GLFWPlatform final : public BzfPlatform
 {
 public:
     GLFWPlatform();
@@ -23,6 +24,7 @@ public:
 
     BzfWindow* createWindow(int width, int height, BzfMonitor *monitor = nullptr, int positionX = -1, int positionY = -1);
     BzfWindow* createWindow(BzfResolution resolution, BzfMonitor *monitor = nullptr);
+    void destroyWindow(BzfWindow* window);
 
     // Audio
     BzfAudio *getAudio();
@@ -32,9 +34,6 @@ public:
 
     bool isGameRunning() const;
 
-    // Timers
-    double getGameTime() const;
-
     // Monitors
     BzfMonitor* getPrimaryMonitor() const;
     std::vector<BzfMonitor*> getMonitors() const;
@@ -46,12 +45,16 @@ public:
     void GLSetVersion(BzfGLProfile profile, unsigned short majorVersion, unsigned short minorVersion) const;
     // Set minumum color depth
     void GLSetRGBA(unsigned short red, unsigned short green, unsigned short blue, unsigned short alpha) const;
+    void GLSetContextFlags(int flags) const;
 
     // Events
     // This will poll for events and call any set callbacks
     void pollEvents();
+    void waitEvents(double timeout);
+
+    bool hasVisibleWindow() const;
 
-    // Callback triggers
+    // Callback triggers, which pass the events on to the platform that owns the window
     static void callResizeCallback(GLFWwindow* window, int width, int height);
     static void callMoveCallback(GLFWwindow* window, int xpos, int ypos);
     static void callKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
@@ -64,35 +67,35 @@ public:
     void stopTextInput();
     bool isTextInput();
 
+    // Input translation
+    static BzfKey keyFromGLFW(int key);
+    static int modsFromGLFW(int glfwMods);
+
 private:
-    static GLFWPlatform *platform;
     std::vector<GLFWWindow*> windows;
     GLFWJoystick *joystick;
-    double startTime;
     bool inTextInputMode;
     bool joystickButtonPressed[BZF_JOY_LAST_BUTTON];
 #if (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 3) || GLFW_VERSION_MAJOR > 3
     BzfJoyHatDirection joystickHatDirection[BZF_JOY_LAST_HAT];
 #endif
 
-    static BzfKey keyFromGLFW(int key);
-    static int modsFromGLFW(int glfwMods);
+    void pollJoystick();
 
     static void error_callback(int error, const char* description);
 };
 
-class GLFWWindow : public BzfWindow
+class GLFWWindow final : public BzfWindow
 {
 public:
+    // With shareWith, the context shares its objects with that window's context
     GLFWWindow(GLFWPlatform *platform, int width, int height, GLFWMonitor *monitor = nullptr, int positionX = -1,
-               int positionY = -1);
-    GLFWWindow(GLFWPlatform *platform, BzfResolution resolution, GLFWMonitor *monitor = nullptr);
+               int positionY = -1, GLFWWindow* shareWith = nullptr);
+    GLFWWindow(GLFWPlatform *platform, BzfResolution resolution, GLFWMonitor *monitor = nullptr,
+               GLFWWindow* shareWith = nullptr);
     ~GLFWWindow();
 
     // Fullscreen/Windowed
-    bool isFullscreen() const;
-    bool setVerticalSync(bool sync) const;
-    bool getWindowSize(int &width, int &height) const;
     bool setWindowed(int width, int height, BzfMonitor* monitor = nullptr, int x = -1, int y = -1);
     bool setFullscreen(BzfResolution resolution, BzfMonitor* monitor = nullptr);
     void iconify() const;
@@ -107,8 +110,12 @@ public:
     bool setConfineMouse(BzfMouseConfinement mode, double x1 = 0, double y1 = 0, double x2 = 0, double y2 = 0);
     BzfMouseConfinement getConfineMouse();
 
+    // Swap policy
+    BzfSwapPolicy setSwapPolicy(BzfSwapPolicy policy) const;
+
     // Drawing/context
     void makeContextCurrent() const;
+    void releaseContext() const;
     void swapBuffers() const;
 
     // Gamma control
@@ -120,17 +127,25 @@ public:
     bool shouldClose() const;
     GLFWwindow *getWindow() const;
     GLFWPlatform *getPlatform() const;
+    // Keep the window state up to date
+    void refreshState();
 
 private:
     GLFWPlatform *platform;
     GLFWwindow *window;
-    bool fullscreen;
     float gamma;
 
     void assignCallbacks();
+    // Make the new context current and load its functions
+    void loadContext();
+    BzfWindowState queryState() const;
+    // The framebuffer size and position callbacks are set by GLFWPlatform, since they also call the user's callbacks
+    static void sizeCallback(GLFWwindow* window, int width, int height);
+    static void iconifyCallback(GLFWwindow* window, int iconified);
+    static void focusCallback(GLFWwindow* window, int focused);
 };
 
-class GLFWJoystick : public BzfJoystick
+class GLFWJoystick final : public BzfJoystick
 {
 public:
     GLFWJoystick();
@@ -1,4 +1,5 @@
 #include "GLHelloWorld.h"
+#include "BzfProfiler.h"
 
 #include <string.h>
 
@@ -30,12 +31,48 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
-GLHelloWorld::GLHelloWorld(const char* filename, int width, int height)
-{
+// Samples an offscreen buffer across the whole viewport, used to upsample scaled rendering
+static const GLchar* upsampleVertexSource = R"glsl(
+		#version 100
+		precision highp float;
 
-    const char* fragShader = readShader(filename);
+		attribute vec4 iPosition;
+		varying vec2 texCoord;
+		void main(){
+			texCoord = iPosition.xy * 0.5 + 0.5;
+			gl_Position = iPosition;
+		}
+	)glsl";
 
-    const GLchar* vertexSource = R"glsl(
+static const GLchar* upsampleFragmentSource = R"glsl(
+		#version 100
+		precision mediump float;
+
+		uniform sampler2D source;
+		varying vec2 texCoord;
+		void main(){
+			gl_FragColor = texture2D(source, texCoord);
+		}
+	)glsl";
+
+GLHelloWorld::GLHelloWorld(const char* filename, int width, int height, GLResourceManager *_resources,
+                           const char *source) :
+    vtx(0), frag(0), resources(_resources), uniforms(_resources != nullptr ? _resources->getUniformCache() : ownUniforms),
+    windowWidth(width), windowHeight(height), renderScale(1.0f), renderWidth(width), renderHeight(height),
+    scaledTarget(nullptr), outputTarget(nullptr), upsample_program(0), upsample_position(-1), upsample_source(-1),
+    dynamicResolution(false), lastFrameTime(0.0)
+{
+    // The functions were loaded by whoever made the context current, see loadGLFunctions()
+    shader_program = getProgram(filename, [&]()
+    {
+        const char* fragShader = (source != nullptr) ? source : readShader(filename);
+        if (fragShader == nullptr)
+        {
+            fprintf(stderr, "Unable to read the shader %s\n", filename);
+            exit(-10);
+        }
+
+        const GLchar* vertexSource = R"glsl(
 		#version 100
 		precision highp float;
 
@@ -45,7 +82,7 @@ GLHelloWorld::GLHelloWorld(const char* filename, int width, int height)
 		}
 	)glsl";
 
-    const GLchar* fragmentTemplate = R"glsl(
+        const GLchar* fragmentTemplate = R"glsl(
 		#version 100
 		precision highp float;
 
@@ -68,33 +105,18 @@ GLHelloWorld::GLHelloWorld(const char* filename, int width, int height)
 		}
 	)glsl";
 
-    GLchar* fragmentSource = (GLchar*)malloc(strlen(fragmentTemplate) + strlen(fragShader) + 1);
-
-    sprintf(fragmentSource, fragmentTemplate, fragShader);
-
-    // Initialize GLEW
-    glewExperimental = GL_TRUE;
-    glewInit();
-
-    GLint success;
-
-    vtx = compileShader(GL_VERTEX_SHADER, vertexSource);
-    frag = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
-    shader_program = glCreateProgram();
-    glAttachShader(shader_program, vtx);
-    glAttachShader(shader_program, frag);
-    glLinkProgram(shader_program);
-
-    glGetProgramiv(shader_program, GL_LINK_STATUS, &success);
-    if (!success)
-        exit(-4);
+        GLchar* fragmentSource = (GLchar*)malloc(strlen(fragmentTemplate) + strlen(fragShader) + 1);
 
-    glDeleteShader(vtx);
-    glDeleteShader(frag);
-    glReleaseShaderCompiler();
+        sprintf(fragmentSource, fragmentTemplate, fragShader);
 
-    glUseProgram(shader_program);
+        vtx = compileShader(GL_VERTEX_SHADER, vertexSource);
+        frag = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+        return linkProgram(vtx, frag);
+    });
+    state.useProgram(shader_program);
     glValidateProgram(shader_program);
+    // The effect is drawn from client memory
+    state.bindBuffer(GL_ARRAY_BUFFER, 0);
 
     attrib_position = glGetAttribLocation(shader_program, "iPosition");
     sampler_channel[0] = glGetUniformLocation(shader_program, "iChannel0");
@@ -114,6 +136,13 @@ GLHelloWorld::GLHelloWorld(const char* filename, int width, int height)
 
 GLHelloWorld::~GLHelloWorld()
 {
+    delete scaledTarget;
+    delete outputTarget;
+    if (resources != nullptr)
+        return;
+    if (upsample_program != 0)
+        state.deleteProgram(upsample_program);
+    state.deleteProgram(shader_program);
 }
 
 char* GLHelloWorld::readFile(const char *filename)
@@ -160,8 +189,6 @@ char* GLHelloWorld::readShader(const char *filename)
         {
             path = "../" + path;
             shader = readFile(path.c_str());
-            if (shader == nullptr)
-                exit(-10);
         }
     }
     return shader;
@@ -195,20 +222,61 @@ GLuint GLHelloWorld::compileShader(GLenum type, const char* source)
     return shader;
 }
 
+GLuint GLHelloWorld::linkProgram(GLuint vertexShader, GLuint fragmentShader)
+{
+    GLint success;
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+        exit(-4);
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    return program;
+}
+
+GLuint GLHelloWorld::getProgram(const std::string &name, std::function<GLuint()> build)
+{
+    if (resources != nullptr)
+        return resources->getProgram(name, build);
+    return build();
+}
+
+std::unique_lock<std::recursive_mutex> GLHelloWorld::lockProgram(GLuint program)
+{
+    // Programs of the window's own are only ever used from the thread that draws the window
+    if (resources == nullptr)
+        return std::unique_lock<std::recursive_mutex>();
+    return std::unique_lock<std::recursive_mutex>(resources->getProgramLock(program));
+}
+
 void GLHelloWorld::resize(int width, int height)
 {
-    glUniform3f(uniform_res, (float)width, (float)height, 0.0f);
-    glViewport(0, 0, width, height);
-    setPosition(width / 2, height / 2, width / 2, height / 2);
+    windowWidth = width;
+    windowHeight = height;
+    mouse[0] = mouse[2] = width / 2;
+    mouse[1] = mouse[3] = height / 2;
+    applyResolution();
 }
 
 void GLHelloWorld::setPosition(double curX, double curY, double clickX, double clickY)
 {
-    glUniform4f(uniform_mouse, (float)curX, (float)curY, (float)clickX, (float)clickY);
+    mouse[0] = curX;
+    mouse[1] = curY;
+    mouse[2] = clickX;
+    mouse[3] = clickY;
+    uploadPosition();
 }
 
 void GLHelloWorld::drawFrame(double abstime)
 {
+    BZF_PROFILE_ZONE("GLHelloWorld::drawFrame");
     static const GLfloat vertices[] =
     {
         -1.0f, -1.0f,
@@ -217,12 +285,246 @@ void GLHelloWorld::drawFrame(double abstime)
             1.0f, 1.0f,
         };
 
-    if (uniform_time >= 0)
-        glUniform1f(uniform_time, abstime);
+    // Bind the programs again in each frame, so that changes made to them through another context are seen
+    if (resources != nullptr)
+        state.invalidateProgram();
+
+    if (dynamicResolution)
+    {
+        if (lastFrameTime > 0.0)
+            setRenderScale(scaleController.update(abstime - lastFrameTime));
+        lastFrameTime = abstime;
+    }
+
+    bool scaled = scaledTarget != nullptr;
+    if (scaled)
+    {
+        scaledTarget->bind();
+        state.viewport(0, 0, renderWidth, renderHeight);
+    }
+    else
+    {
+        if (outputTarget != nullptr)
+            outputTarget->bind();
+        else
+            state.bindFramebuffer(0);
+        state.viewport(0, 0, windowWidth, windowHeight);
+    }
+
+    {
+        // Another window may set the uniforms to its own values between ours being set and drawn with
+        std::unique_lock<std::recursive_mutex> programLock = lockProgram(shader_program);
+        state.useProgram(shader_program);
+        uniforms.set1f(shader_program, uniform_time, abstime);
+        // Another window may have drawn the same program with its own values since the last frame
+        if (resources != nullptr)
+        {
+            uniforms.set3f(shader_program, uniform_res, (float)renderWidth, (float)renderHeight, 0.0f);
+            uploadPosition();
+        }
+
+        state.clearColor(0.0f, 0.0f, 0.0f, 1.0);
+        glClear(GL_COLOR_BUFFER_BIT);
+        state.enableVertexAttribArray(attrib_position);
+        state.vertexAttribPointer(attrib_position, 2, GL_FLOAT, GL_FALSE, 0, vertices);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+
+    if (scaled)
+    {
+        // Upsample the scaled image to the window
+        if (outputTarget != nullptr)
+            outputTarget->bind();
+        else
+            scaledTarget->unbind();
+        state.viewport(0, 0, windowWidth, windowHeight);
+        state.useProgram(upsample_program);
+        state.activeTexture(GL_TEXTURE0);
+        state.bindTexture(GL_TEXTURE_2D, scaledTarget->getTexture());
+        state.enableVertexAttribArray(upsample_position);
+        state.vertexAttribPointer(upsample_position, 2, GL_FLOAT, GL_FALSE, 0, vertices);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        // Do not leave the texture bound while it is being rendered into next frame
+        state.bindTexture(GL_TEXTURE_2D, 0);
+    }
+}
+
+void GLHelloWorld::setRenderScale(float scale)
+{
+    if (scale > 1.0f)
+        scale = 1.0f;
+    else if (scale < 0.1f)
+        scale = 0.1f;
+
+    if (scale == renderScale)
+        return;
+
+    renderScale = scale;
+    applyResolution();
+}
 
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glEnableVertexAttribArray(attrib_position);
-    glVertexAttribPointer(attrib_position, 2, GL_FLOAT, GL_FALSE, 0, vertices);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+float GLHelloWorld::getRenderScale() const
+{
+    return renderScale;
+}
+
+void GLHelloWorld::enableDynamicResolution(double targetFrameTime, float minScale)
+{
+    scaleController.setTargetFrameTime(targetFrameTime);
+    scaleController.setScaleRange(minScale, 1.0f);
+    scaleController.reset();
+    dynamicResolution = true;
+    lastFrameTime = 0.0;
+}
+
+void GLHelloWorld::disableDynamicResolution()
+{
+    dynamicResolution = false;
+    setRenderScale(1.0f);
+}
+
+bool GLHelloWorld::isDynamicResolution() const
+{
+    return dynamicResolution;
+}
+
+void GLHelloWorld::setOffscreen(bool offscreen)
+{
+    if (offscreen == (outputTarget != nullptr))
+        return;
+
+    if (offscreen)
+    {
+        outputTarget = new GLRenderTarget(state);
+        if (!outputTarget->resize(windowWidth, windowHeight))
+        {
+            delete outputTarget;
+            outputTarget = nullptr;
+        }
+    }
+    else
+    {
+        outputTarget->unbind();
+        delete outputTarget;
+        outputTarget = nullptr;
+    }
+}
+
+const GLUniformCache& GLHelloWorld::getUniformCache() const
+{
+    return uniforms;
+}
+
+GLStateCache& GLHelloWorld::getStateCache()
+{
+    return state;
+}
+
+bool GLHelloWorld::isOffscreen() const
+{
+    return outputTarget != nullptr;
+}
+
+GLRenderTarget* GLHelloWorld::getOutputTarget() const
+{
+    return outputTarget;
+}
+
+bool GLHelloWorld::readPixels(std::vector<unsigned char> &pixels)
+{
+    pixels.resize((size_t)windowWidth * windowHeight * 4);
+    if (pixels.empty())
+        return false;
+
+    if (outputTarget != nullptr)
+        outputTarget->bind();
+    else
+        state.bindFramebuffer(0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, windowWidth, windowHeight, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+unsigned int GLHelloWorld::getPixelChecksum()
+{
+    std::vector<unsigned char> pixels;
+    if (!readPixels(pixels))
+        return 0;
+
+    // 32-bit FNV-1a
+    unsigned int hash = 2166136261u;
+    for (unsigned char pixel : pixels)
+    {
+        hash ^= pixel;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void GLHelloWorld::applyResolution()
+{
+    if (outputTarget != nullptr && !outputTarget->resize(windowWidth, windowHeight))
+    {
+        delete outputTarget;
+        outputTarget = nullptr;
+    }
+
+    if (renderScale < 1.0f)
+    {
+        renderWidth = (int)(windowWidth * renderScale + 0.5f);
+        renderHeight = (int)(windowHeight * renderScale + 0.5f);
+
+        if (upsample_program == 0)
+        {
+            upsample_program = getProgram("upsample", [&]()
+            {
+                return linkProgram(compileShader(GL_VERTEX_SHADER, upsampleVertexSource),
+                                   compileShader(GL_FRAGMENT_SHADER, upsampleFragmentSource));
+            });
+            upsample_position = glGetAttribLocation(upsample_program, "iPosition");
+            upsample_source = glGetUniformLocation(upsample_program, "source");
+            std::unique_lock<std::recursive_mutex> programLock = lockProgram(upsample_program);
+            state.useProgram(upsample_program);
+            uniforms.set1i(upsample_program, upsample_source, 0);
+        }
+
+        if (scaledTarget == nullptr)
+            scaledTarget = new GLRenderTarget(state);
+        if (!scaledTarget->resize(renderWidth, renderHeight))
+        {
+            // Fall back to rendering directly to the window
+            delete scaledTarget;
+            scaledTarget = nullptr;
+            renderScale = 1.0f;
+        }
+    }
+    else if (scaledTarget != nullptr)
+    {
+        delete scaledTarget;
+        scaledTarget = nullptr;
+    }
+
+    if (scaledTarget == nullptr)
+    {
+        renderWidth = windowWidth;
+        renderHeight = windowHeight;
+    }
+
+    std::unique_lock<std::recursive_mutex> programLock = lockProgram(shader_program);
+    state.useProgram(shader_program);
+    uniforms.set3f(shader_program, uniform_res, (float)renderWidth, (float)renderHeight, 0.0f);
+    state.viewport(0, 0, windowWidth, windowHeight);
+    uploadPosition();
+}
+
+void GLHelloWorld::uploadPosition()
+{
+    // The mouse position is in window pixels, but the effect sees the scaled resolution
+    float scaleX = (float)renderWidth / (windowWidth > 0 ? windowWidth : 1);
+    float scaleY = (float)renderHeight / (windowHeight > 0 ? windowHeight : 1);
+    std::unique_lock<std::recursive_mutex> programLock = lockProgram(shader_program);
+    state.useProgram(shader_program);
+    uniforms.set4f(shader_program, uniform_mouse, (float)mouse[0] * scaleX, (float)mouse[1] * scaleY,
+                   (float)mouse[2] * scaleX, (float)mouse[3] * scaleY);
 }
@@ -1,20 +1,63 @@
 #pragma once
 
-#include <GL/glew.h>
+#include "BzfGL.h"
 #include "BzfPlatform.h"
+#include "GLRenderTarget.h"
+#include "GLResourceManager.h"
+#include "GLStateCache.h"
+#include "GLUniformCache.h"
+#include "RenderScaleController.h"
+
+#include <mutex>
+#include <vector>
 
 class GLHelloWorld
 {
 public:
-    GLHelloWorld(const char* fragShader, int width, int height);
+    // With a resource manager, the programs are taken from it, so that windows sharing their contexts build them once.
+    // The shader is read from the file unless its source is given, like when a job read it ahead of time.
+    GLHelloWorld(const char* fragShader, int width, int height, GLResourceManager *resources = nullptr,
+                 const char *source = nullptr);
     ~GLHelloWorld();
-    char* readFile(const char *filename);
-    char* readShader(const char *filename);
+    // These only touch the file, so they can run on any thread. They return nullptr if the file can not be read.
+    static char* readFile(const char *filename);
+    static char* readShader(const char *filename);
     GLuint compileShader(GLenum type, const char* source);
     void resize(int width, int height);
     void setPosition(double curX, double curY, double clickX, double clickY);
     void drawFrame(double abstime);
+
+    // Render scaling
+    // Draw into an offscreen buffer at a fraction of the window size and upsample it to the window
+    void setRenderScale(float scale);
+    float getRenderScale() const;
+    // Let the render scale follow the frame time, trying to stay within the given budget (in seconds)
+    void enableDynamicResolution(double targetFrameTime, float minScale = 0.5f);
+    void disableDynamicResolution();
+    bool isDynamicResolution() const;
+
+    // Offscreen rendering
+    // Draw into a framebuffer object the size of the window instead of the window itself
+    void setOffscreen(bool offscreen);
+    bool isOffscreen() const;
+    GLRenderTarget* getOutputTarget() const;
+    // Read back the last frame as RGBA, bottom row first
+    bool readPixels(std::vector<unsigned char> &pixels);
+    unsigned int getPixelChecksum();
+
+    // Uniform upload statistics
+    const GLUniformCache& getUniformCache() const;
+    // State changes of the context this instance draws in. Anything else changing GL state in that context has to
+    // either go through this or invalidate it.
+    GLStateCache& getStateCache();
 private:
+    GLuint linkProgram(GLuint vertexShader, GLuint fragmentShader);
+    GLuint getProgram(const std::string &name, std::function<GLuint()> build);
+    // Holds the lock of a program that comes from the resource manager, and nothing otherwise
+    std::unique_lock<std::recursive_mutex> lockProgram(GLuint program);
+    void applyResolution();
+    void uploadPosition();
+
     GLuint vtx, frag;
 
     GLuint shader_program;
@@ -27,4 +70,26 @@ private:
     GLint uniform_mouse;
     GLint uniform_res;
     GLint uniform_srate;
+    // Programs are only deleted here when they did not come from the resource manager
+    GLResourceManager *resources;
+    GLUniformCache ownUniforms;
+    // The resource manager's when there is one, as uniform values are part of the shared programs
+    GLUniformCache &uniforms;
+    GLStateCache state;
+
+    // Window size and mouse position, in window pixels
+    int windowWidth, windowHeight;
+    double mouse[4];
+
+    // Render scaling
+    float renderScale;
+    int renderWidth, renderHeight;
+    GLRenderTarget *scaledTarget;
+    GLRenderTarget *outputTarget;
+    GLuint upsample_program;
+    GLint upsample_position;
+    GLint upsample_source;
+    bool dynamicResolution;
+    RenderScaleController scaleController;
+    double lastFrameTime;
 };
@@ -0,0 +1,212 @@
+#include "GLMetricsOverlay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Positions are given in pixels from the bottom left corner
+static const GLchar* overlayVertexSource = R"glsl(
+		#version 100
+		precision highp float;
+
+		attribute vec2 iPosition;
+		uniform vec2 iViewport;
+		void main(){
+			gl_Position = vec4(iPosition / iViewport * 2.0 - 1.0, 0.0, 1.0);
+		}
+	)glsl";
+
+static const GLchar* overlayFragmentSource = R"glsl(
+		#version 100
+		precision mediump float;
+
+		uniform vec4 iColor;
+		void main(){
+			gl_FragColor = iColor;
+		}
+	)glsl";
+
+// Glyphs of 3x5 pixels for the digits, '.' and '-'. Each octal digit is a row of 3 pixels, starting at the top.
+static const unsigned short digitGlyphs[] =
+{
+    075557, 026227, 071747, 071717, 055711, 074717, 074757, 071111, 075757, 075717
+};
+static const unsigned short pointGlyph = 000002;
+static const unsigned short minusGlyph = 000700;
+
+static const int glyphScale = 3;
+static const int graphHeight = 60;
+// Frames at twice the budget reach the top of the graph
+static const double graphRange = 2.0;
+
+static const GLfloat backgroundColor[] = { 0.0f, 0.0f, 0.0f, 0.6f };
+static const GLfloat budgetColor[] = { 1.0f, 1.0f, 1.0f, 0.5f };
+static const GLfloat goodColor[] = { 0.2f, 0.9f, 0.2f, 1.0f };
+static const GLfloat lateColor[] = { 0.9f, 0.2f, 0.2f, 1.0f };
+static const GLfloat lineColors[][4] =
+{
+    { 1.0f, 1.0f, 1.0f, 1.0f },
+    { 1.0f, 0.9f, 0.2f, 1.0f },
+    { 0.3f, 0.8f, 1.0f, 1.0f },
+    { 1.0f, 0.5f, 0.9f, 1.0f }
+};
+
+static GLuint compileOverlayShader(GLenum type, const char *source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        fprintf(stderr, "\n\n%s\n\n", log);
+        exit(-5);
+    }
+    return shader;
+}
+
+GLMetricsOverlay::GLMetricsOverlay(GLStateCache &_state) : state(_state), budget(1.0 / 60.0), historyNext(0)
+{
+    for (int i = 0; i < historySize; ++i)
+        history[i] = 0.0;
+
+    GLuint vertexShader = compileOverlayShader(GL_VERTEX_SHADER, overlayVertexSource);
+    GLuint fragmentShader = compileOverlayShader(GL_FRAGMENT_SHADER, overlayFragmentSource);
+    program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+        exit(-4);
+
+    attrib_position = glGetAttribLocation(program, "iPosition");
+    uniform_viewport = glGetUniformLocation(program, "iViewport");
+    uniform_color = glGetUniformLocation(program, "iColor");
+}
+
+GLMetricsOverlay::~GLMetricsOverlay()
+{
+    state.deleteProgram(program);
+}
+
+void GLMetricsOverlay::setBudget(double seconds)
+{
+    budget = seconds;
+}
+
+void GLMetricsOverlay::addFrameTime(double seconds)
+{
+    history[historyNext] = seconds;
+    historyNext = (historyNext + 1) % historySize;
+}
+
+void GLMetricsOverlay::setLine(int line, double value, int decimals)
+{
+    if (line < 0)
+        return;
+    if (line >= (int)lines.size())
+        lines.resize(line + 1, Line { 0.0, 0 });
+    lines[line].value = value;
+    lines[line].decimals = decimals;
+}
+
+void GLMetricsOverlay::draw(int width, int height)
+{
+    const float margin = 8.0f;
+    const float lineHeight = 7.0f * glyphScale;
+    const float panelWidth = historySize * 2.0f + 2.0f * margin;
+    const float panelHeight = graphHeight + lines.size() * lineHeight + 2.0f * margin;
+    const float left = margin;
+    const float top = height - margin;
+
+    state.bindBuffer(GL_ARRAY_BUFFER, 0);
+    state.viewport(0, 0, width, height);
+    state.useProgram(program);
+    glUniform2f(uniform_viewport, (GLfloat)width, (GLfloat)height);
+    state.enableVertexAttribArray(attrib_position);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    std::vector<GLfloat> vertices;
+    addRectangle(vertices, left, top - panelHeight, panelWidth, panelHeight);
+    drawBatch(vertices, backgroundColor);
+
+    // Frame time graph, oldest frame on the left
+    const float graphBottom = top - margin - graphHeight;
+    std::vector<GLfloat> good, late;
+    for (int i = 0; i < historySize; ++i)
+    {
+        double frameTime = history[(historyNext + i) % historySize];
+        float barHeight = (float)(frameTime / (budget * graphRange) * graphHeight);
+        if (barHeight > graphHeight)
+            barHeight = graphHeight;
+        addRectangle(frameTime > budget ? late : good, left + margin + i * 2.0f, graphBottom, 2.0f, barHeight);
+    }
+    drawBatch(good, goodColor);
+    drawBatch(late, lateColor);
+
+    vertices.clear();
+    addRectangle(vertices, left + margin, graphBottom + (float)(graphHeight / graphRange), historySize * 2.0f, 1.0f);
+    drawBatch(vertices, budgetColor);
+
+    // Numbers, one per line below the graph
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        char text[32];
+        snprintf(text, sizeof(text), "%.*f", lines[i].decimals, lines[i].value);
+        vertices.clear();
+        addText(vertices, left + margin, graphBottom - (i + 1) * lineHeight, text);
+        drawBatch(vertices, lineColors[i % (sizeof(lineColors) / sizeof(lineColors[0]))]);
+    }
+
+    glDisable(GL_BLEND);
+}
+
+void GLMetricsOverlay::addRectangle(std::vector<GLfloat> &vertices, float x, float y, float width, float height)
+{
+    const GLfloat corners[] =
+    {
+        x, y, x + width, y, x, y + height,
+        x, y + height, x + width, y, x + width, y + height
+    };
+    vertices.insert(vertices.end(), corners, corners + 12);
+}
+
+void GLMetricsOverlay::addText(std::vector<GLfloat> &vertices, float x, float y, const char *text)
+{
+    for (; *text != '\0'; ++text, x += 4.0f * glyphScale)
+    {
+        unsigned short glyph;
+        if (*text >= '0' && *text <= '9')
+            glyph = digitGlyphs[*text - '0'];
+        else if (*text == '.')
+            glyph = pointGlyph;
+        else if (*text == '-')
+            glyph = minusGlyph;
+        else
+            continue;
+
+        for (int row = 0; row < 5; ++row)
+            for (int column = 0; column < 3; ++column)
+                if (glyph & (1 << ((4 - row) * 3 + (2 - column))))
+                    addRectangle(vertices, x + column * glyphScale, y + (4 - row) * glyphScale, glyphScale, glyphScale);
+    }
+}
+
+void GLMetricsOverlay::drawBatch(const std::vector<GLfloat> &vertices, const GLfloat *color)
+{
+    if (vertices.empty())
+        return;
+
+    glUniform4fv(uniform_color, 1, color);
+    state.vertexAttribPointer(attrib_position, 2, GL_FLOAT, GL_FALSE, 0, vertices.data());
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(vertices.size() / 2));
+}
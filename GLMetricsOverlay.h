@@ -0,0 +1,49 @@
+#pragma once
+
+#include "BzfGL.h"
+#include "GLStateCache.h"
+
+#include <vector>
+
+// Draws a graph of recent frame times and a few numbers in the corner of the window. Numbers use a built in 3x5
+// pixel font with only digits, so each line is told apart by its color.
+class GLMetricsOverlay
+{
+public:
+    // Bindings are made through the state cache of the context the overlay is drawn in
+    GLMetricsOverlay(GLStateCache &state);
+    ~GLMetricsOverlay();
+
+    // Frame time budget in seconds, marked in the graph. Longer frames are drawn in red.
+    void setBudget(double seconds);
+    void addFrameTime(double seconds);
+    // Set the number shown on a line, which is added if needed
+    void setLine(int line, double value, int decimals = 0);
+
+    // Draw into the currently bound framebuffer, which is width by height pixels
+    void draw(int width, int height);
+
+private:
+    static const int historySize = 120;
+
+    struct Line
+    {
+        double value;
+        int decimals;
+    };
+
+    void addRectangle(std::vector<GLfloat> &vertices, float x, float y, float width, float height);
+    void addText(std::vector<GLfloat> &vertices, float x, float y, const char *text);
+    void drawBatch(const std::vector<GLfloat> &vertices, const GLfloat *color);
+
+    GLStateCache &state;
+    GLuint program;
+    GLint attrib_position;
+    GLint uniform_viewport;
+    GLint uniform_color;
+
+    double budget;
+    double history[historySize];
+    int historyNext;
+    std::vector<Line> lines;
+};
@@ -0,0 +1,93 @@
+#include "GLRenderTarget.h"
+
+#include <stdio.h>
+
+GLRenderTarget::GLRenderTarget(GLStateCache &_state) : state(_state), framebuffer(0), texture(0), width(0), height(0)
+{
+}
+
+GLRenderTarget::~GLRenderTarget()
+{
+    destroy();
+}
+
+bool GLRenderTarget::resize(int _width, int _height)
+{
+    if (_width < 1)
+        _width = 1;
+    if (_height < 1)
+        _height = 1;
+
+    if (framebuffer != 0 && _width == width && _height == height)
+        return true;
+
+    destroy();
+
+    width = _width;
+    height = _height;
+
+    // OpenGL ES 2.0 only guarantees RGBA8 color attachments through textures, so avoid renderbuffers here
+    glGenTextures(1, &texture);
+    state.bindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    state.bindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &framebuffer);
+    state.bindFramebuffer(framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    state.bindFramebuffer(0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        fprintf(stderr, "Offscreen framebuffer of %dx%d is incomplete (0x%x)\n", width, height, status);
+        destroy();
+        return false;
+    }
+
+    return true;
+}
+
+void GLRenderTarget::bind() const
+{
+    state.bindFramebuffer(framebuffer);
+}
+
+void GLRenderTarget::unbind() const
+{
+    state.bindFramebuffer(0);
+}
+
+GLuint GLRenderTarget::getTexture() const
+{
+    return texture;
+}
+
+int GLRenderTarget::getWidth() const
+{
+    return width;
+}
+
+int GLRenderTarget::getHeight() const
+{
+    return height;
+}
+
+void GLRenderTarget::destroy()
+{
+    if (framebuffer != 0)
+    {
+        state.deleteFramebuffer(framebuffer);
+        framebuffer = 0;
+    }
+    if (texture != 0)
+    {
+        state.deleteTexture(texture);
+        texture = 0;
+    }
+    width = height = 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "BzfGL.h"
+#include "GLStateCache.h"
+
+// An offscreen color buffer backed by a framebuffer object. It can be rendered into and then sampled as a texture.
+class GLRenderTarget
+{
+public:
+    // Bindings are made through the state cache of the context the target is used in
+    GLRenderTarget(GLStateCache &state);
+    ~GLRenderTarget();
+
+    // (Re)allocate the color buffer. Returns false if the framebuffer is incomplete.
+    bool resize(int width, int height);
+    // Direct rendering into this target
+    void bind() const;
+    // Direct rendering back to the default framebuffer
+    void unbind() const;
+
+    GLuint getTexture() const;
+    int getWidth() const;
+    int getHeight() const;
+
+private:
+    void destroy();
+
+    GLStateCache &state;
+    GLuint framebuffer;
+    GLuint texture;
+    int width;
+    int height;
+};
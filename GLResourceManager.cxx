@@ -0,0 +1,55 @@
+#include "GLResourceManager.h"
+
+GLResourceManager::GLResourceManager() : builds(0), reuses(0)
+{
+}
+
+GLResourceManager::~GLResourceManager()
+{
+    for (auto &program : programs)
+        glDeleteProgram(program.second);
+    for (auto &lock : programLocks)
+        delete lock.second;
+}
+
+GLuint GLResourceManager::getProgram(const std::string &name, std::function<GLuint()> build)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = programs.find(name);
+    if (found != programs.end())
+    {
+        ++reuses;
+        return found->second;
+    }
+
+    GLuint program = build();
+    programs[name] = program;
+    ++builds;
+    return program;
+}
+
+std::recursive_mutex& GLResourceManager::getProgramLock(GLuint program)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::recursive_mutex *&programLock = programLocks[program];
+    if (programLock == nullptr)
+        programLock = new std::recursive_mutex;
+    return *programLock;
+}
+
+GLUniformCache& GLResourceManager::getUniformCache()
+{
+    return uniforms;
+}
+
+unsigned long GLResourceManager::getBuildCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return builds;
+}
+
+unsigned long GLResourceManager::getReuseCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return reuses;
+}
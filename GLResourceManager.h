@@ -0,0 +1,48 @@
+#pragma once
+
+#include "BzfGL.h"
+#include "GLUniformCache.h"
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// The programs of a group of windows whose contexts share their objects (see BzfPlatform::GLSetSharedContexts()), so
+// that each program is built once for all of them instead of once per window.
+//
+// Uniforms are part of a program, so the values written to them are tracked here as well rather than per window. This
+// also means that windows which draw the same program from different threads have to take turns, by holding the
+// program's lock from setting its uniforms until they drew with it. The manager itself can be used from any thread, as
+// long as a context of the group is current on it, including when deleting it.
+class GLResourceManager
+{
+public:
+    GLResourceManager();
+    ~GLResourceManager();
+
+    // The program with this name, which build() makes (and links) the first time it is asked for. The program belongs
+    // to the manager and must not be deleted by the caller.
+    GLuint getProgram(const std::string &name, std::function<GLuint()> build);
+
+    // Held while a window sets the uniforms of the program and draws with it. The lock is recursive, so that functions
+    // which set a uniform can take it whether or not their caller already did.
+    std::recursive_mutex& getProgramLock(GLuint program);
+
+    // Uniform values of the programs of the group
+    GLUniformCache& getUniformCache();
+
+    // Statistics
+    unsigned long getBuildCount() const;
+    unsigned long getReuseCount() const;
+
+private:
+    // Guards the programs, their locks and the statistics, and is held while a program is built so that it is only
+    // built once when two threads ask for it at the same time
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, GLuint> programs;
+    std::unordered_map<GLuint, std::recursive_mutex*> programLocks;
+    GLUniformCache uniforms;
+    unsigned long builds;
+    unsigned long reuses;
+};
@@ -0,0 +1,256 @@
+#include "GLStateCache.h"
+
+GLStateCache::GLStateCache() : issued(0), skipped(0)
+{
+    invalidate();
+}
+
+void GLStateCache::useProgram(GLuint _program)
+{
+    if (changed(!programKnown || program != _program))
+    {
+        glUseProgram(_program);
+        program = _program;
+        programKnown = true;
+    }
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    if (target == GL_ARRAY_BUFFER)
+    {
+        if (changed(!arrayBufferKnown || arrayBuffer != buffer))
+        {
+            glBindBuffer(target, buffer);
+            arrayBuffer = buffer;
+            arrayBufferKnown = true;
+        }
+    }
+    else if (target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+        if (changed(!elementBufferKnown || elementBuffer != buffer))
+        {
+            glBindBuffer(target, buffer);
+            elementBuffer = buffer;
+            elementBufferKnown = true;
+        }
+    }
+    else
+        glBindBuffer(target, buffer);
+}
+
+void GLStateCache::bindFramebuffer(GLuint _framebuffer)
+{
+    if (changed(!framebufferKnown || framebuffer != _framebuffer))
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+        framebuffer = _framebuffer;
+        framebufferKnown = true;
+    }
+}
+
+void GLStateCache::activeTexture(GLenum unit)
+{
+    if (changed(!activeUnitKnown || activeUnit != unit))
+    {
+        glActiveTexture(unit);
+        activeUnit = unit;
+        activeUnitKnown = true;
+    }
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint _texture)
+{
+    int unit = activeUnitKnown ? (int)(activeUnit - GL_TEXTURE0) : -1;
+    if (target != GL_TEXTURE_2D || unit < 0 || unit >= maxTextureUnits)
+    {
+        // Either not tracked or we do not know which unit is active, so the binding can not be trusted afterwards
+        glBindTexture(target, _texture);
+        if (unit >= 0 && unit < maxTextureUnits)
+            textureKnown[unit] = false;
+        else if (unit < 0)
+            for (int i = 0; i < maxTextureUnits; ++i)
+                textureKnown[i] = false;
+        return;
+    }
+
+    if (changed(!textureKnown[unit] || texture[unit] != _texture))
+    {
+        glBindTexture(target, _texture);
+        texture[unit] = _texture;
+        textureKnown[unit] = true;
+    }
+}
+
+void GLStateCache::enableVertexAttribArray(GLint index)
+{
+    if (index < 0)
+        return;
+    if (index >= maxAttributes)
+    {
+        glEnableVertexAttribArray(index);
+        return;
+    }
+
+    unsigned int bit = 1u << index;
+    if (changed(!(attributesKnown & bit) || !(attributesEnabled & bit)))
+    {
+        glEnableVertexAttribArray(index);
+        attributesKnown |= bit;
+        attributesEnabled |= bit;
+    }
+}
+
+void GLStateCache::disableVertexAttribArray(GLint index)
+{
+    if (index < 0)
+        return;
+    if (index >= maxAttributes)
+    {
+        glDisableVertexAttribArray(index);
+        return;
+    }
+
+    unsigned int bit = 1u << index;
+    if (changed(!(attributesKnown & bit) || (attributesEnabled & bit)))
+    {
+        glDisableVertexAttribArray(index);
+        attributesKnown |= bit;
+        attributesEnabled &= ~bit;
+    }
+}
+
+void GLStateCache::vertexAttribPointer(GLint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                                       const void *pointer)
+{
+    if (index < 0)
+        return;
+    // The pointer is captured together with the current array buffer binding, so that has to be known as well
+    if (index >= maxAttributes || !arrayBufferKnown)
+    {
+        glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+        if (index < maxAttributes)
+            attributes[index].known = false;
+        return;
+    }
+
+    AttributePointer &attribute = attributes[index];
+    if (changed(!attribute.known || attribute.buffer != arrayBuffer || attribute.size != size || attribute.type != type
+                || attribute.normalized != normalized || attribute.stride != stride || attribute.pointer != pointer))
+    {
+        glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+        attribute.known = true;
+        attribute.buffer = arrayBuffer;
+        attribute.size = size;
+        attribute.type = type;
+        attribute.normalized = normalized;
+        attribute.stride = stride;
+        attribute.pointer = pointer;
+    }
+}
+
+void GLStateCache::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (changed(!viewportKnown || viewportRect[0] != x || viewportRect[1] != y || viewportRect[2] != width
+                || viewportRect[3] != height))
+    {
+        glViewport(x, y, width, height);
+        viewportRect[0] = x;
+        viewportRect[1] = y;
+        viewportRect[2] = width;
+        viewportRect[3] = height;
+        viewportKnown = true;
+    }
+}
+
+void GLStateCache::clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+    if (changed(!clearColorKnown || clearColorValue[0] != red || clearColorValue[1] != green
+                || clearColorValue[2] != blue || clearColorValue[3] != alpha))
+    {
+        glClearColor(red, green, blue, alpha);
+        clearColorValue[0] = red;
+        clearColorValue[1] = green;
+        clearColorValue[2] = blue;
+        clearColorValue[3] = alpha;
+        clearColorKnown = true;
+    }
+}
+
+void GLStateCache::deleteProgram(GLuint _program)
+{
+    // A program that is in use stays in use until another one is installed, so the binding does not change
+    glDeleteProgram(_program);
+}
+
+void GLStateCache::deleteFramebuffer(GLuint _framebuffer)
+{
+    glDeleteFramebuffers(1, &_framebuffer);
+    // Deleting the bound framebuffer reverts to the default framebuffer
+    if (framebufferKnown && framebuffer == _framebuffer)
+        framebuffer = 0;
+}
+
+void GLStateCache::deleteTexture(GLuint _texture)
+{
+    glDeleteTextures(1, &_texture);
+    // Deleting a bound texture reverts that unit to texture 0
+    for (int i = 0; i < maxTextureUnits; ++i)
+        if (textureKnown[i] && texture[i] == _texture)
+            texture[i] = 0;
+}
+
+void GLStateCache::invalidate()
+{
+    programKnown = false;
+    program = 0;
+    arrayBufferKnown = false;
+    arrayBuffer = 0;
+    elementBufferKnown = false;
+    elementBuffer = 0;
+    framebufferKnown = false;
+    framebuffer = 0;
+    activeUnitKnown = false;
+    activeUnit = GL_TEXTURE0;
+    for (int i = 0; i < maxTextureUnits; ++i)
+    {
+        textureKnown[i] = false;
+        texture[i] = 0;
+    }
+    attributesKnown = 0;
+    attributesEnabled = 0;
+    for (int i = 0; i < maxAttributes; ++i)
+        attributes[i].known = false;
+    viewportKnown = false;
+    clearColorKnown = false;
+}
+
+void GLStateCache::invalidateProgram()
+{
+    programKnown = false;
+    program = 0;
+}
+
+unsigned long GLStateCache::getIssuedCount() const
+{
+    return issued;
+}
+
+unsigned long GLStateCache::getSkippedCount() const
+{
+    return skipped;
+}
+
+void GLStateCache::resetCounters()
+{
+    issued = skipped = 0;
+}
+
+bool GLStateCache::changed(bool isChanged)
+{
+    if (isChanged)
+        ++issued;
+    else
+        ++skipped;
+    return isChanged;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "BzfGL.h"
+
+// A shadow copy of the OpenGL state of a single context. State changes made through it only reach the driver when
+// they actually change something. Each context needs its own cache, and any code that changes the same state behind
+// its back has to call invalidate() afterwards.
+class GLStateCache
+{
+public:
+    GLStateCache();
+
+    void useProgram(GLuint program);
+    void bindBuffer(GLenum target, GLuint buffer);
+    void bindFramebuffer(GLuint framebuffer);
+    void activeTexture(GLenum unit);
+    void bindTexture(GLenum target, GLuint texture);
+    void enableVertexAttribArray(GLint index);
+    void disableVertexAttribArray(GLint index);
+    void vertexAttribPointer(GLint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                             const void *pointer);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    void clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+
+    // Delete objects, keeping the cache in sync with the bindings GL resets when a bound object is deleted
+    void deleteProgram(GLuint program);
+    void deleteFramebuffer(GLuint framebuffer);
+    void deleteTexture(GLuint texture);
+
+    // Forget everything, so that the next change of each state is sent to GL
+    void invalidate();
+    // Forget the program in use, so that the next useProgram() binds it again. Changes that another context made to a
+    // shared program are only guaranteed to be seen once it is bound again.
+    void invalidateProgram();
+
+    // Statistics
+    unsigned long getIssuedCount() const;
+    unsigned long getSkippedCount() const;
+    void resetCounters();
+
+private:
+    // Only the first few attributes and texture units are tracked, anything above is always passed through
+    static const int maxAttributes = 16;
+    static const int maxTextureUnits = 8;
+
+    struct AttributePointer
+    {
+        bool known;
+        GLuint buffer;
+        GLint size;
+        GLenum type;
+        GLboolean normalized;
+        GLsizei stride;
+        const void *pointer;
+    };
+
+    bool changed(bool isChanged);
+
+    bool programKnown;
+    GLuint program;
+    bool arrayBufferKnown;
+    GLuint arrayBuffer;
+    bool elementBufferKnown;
+    GLuint elementBuffer;
+    bool framebufferKnown;
+    GLuint framebuffer;
+    bool activeUnitKnown;
+    GLenum activeUnit;
+    bool textureKnown[maxTextureUnits];
+    GLuint texture[maxTextureUnits];
+    unsigned int attributesKnown;
+    unsigned int attributesEnabled;
+    AttributePointer attributes[maxAttributes];
+    bool viewportKnown;
+    GLint viewportRect[4];
+    bool clearColorKnown;
+    GLfloat clearColorValue[4];
+
+    unsigned long issued;
+    unsigned long skipped;
+};
@@ -0,0 +1,94 @@
+#include "GLUniformCache.h"
+
+#include <string.h>
+
+GLUniformCache::GLUniformCache() : issued(0), skipped(0)
+{
+}
+
+void GLUniformCache::set1i(GLuint program, GLint location, int x)
+{
+    if (update(program, location, 1, &x))
+        glUniform1i(location, x);
+}
+
+void GLUniformCache::set1f(GLuint program, GLint location, float x)
+{
+    if (update(program, location, 1, &x))
+        glUniform1f(location, x);
+}
+
+void GLUniformCache::set3f(GLuint program, GLint location, float x, float y, float z)
+{
+    const float values[3] = { x, y, z };
+    if (update(program, location, 3, values))
+        glUniform3f(location, x, y, z);
+}
+
+void GLUniformCache::set4f(GLuint program, GLint location, float x, float y, float z, float w)
+{
+    const float values[4] = { x, y, z, w };
+    if (update(program, location, 4, values))
+        glUniform4f(location, x, y, z, w);
+}
+
+void GLUniformCache::invalidate(GLuint program)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if ((GLuint)(it->first >> 32) == program)
+            it = entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+void GLUniformCache::invalidate()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
+
+unsigned long GLUniformCache::getIssuedCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return issued;
+}
+
+unsigned long GLUniformCache::getSkippedCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return skipped;
+}
+
+void GLUniformCache::resetCounters()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    issued = skipped = 0;
+}
+
+bool GLUniformCache::update(GLuint program, GLint location, int components, const void *values)
+{
+    // Uniforms that were optimized out of the program have a location of -1, and GL silently ignores them
+    if (location < 0)
+        return false;
+
+    unsigned long long key = ((unsigned long long)program << 32) | (unsigned int)location;
+    size_t size = components * sizeof(unsigned int);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // Compare the bit patterns rather than the float values, so that -0.0 and NaN are handled like any other value
+    auto it = entries.find(key);
+    if (it != entries.end() && it->second.components == components && memcmp(it->second.bits, values, size) == 0)
+    {
+        ++skipped;
+        return false;
+    }
+
+    Entry &entry = entries[key];
+    entry.components = components;
+    memcpy(entry.bits, values, size);
+    ++issued;
+    return true;
+}
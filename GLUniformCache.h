@@ -0,0 +1,48 @@
+#pragma once
+
+#include "BzfGL.h"
+
+#include <mutex>
+#include <unordered_map>
+
+// Remembers the last value written to each uniform of each program, so that setting a uniform to the value it already
+// has does not reach the driver. The program must be the one currently in use, just like with glUniform*().
+//
+// A cache can be shared by threads that draw through contexts sharing their programs (see GLResourceManager), as long
+// as they do not set the uniforms of the same program at the same time.
+class GLUniformCache
+{
+public:
+    GLUniformCache();
+
+    void set1i(GLuint program, GLint location, int x);
+    void set1f(GLuint program, GLint location, float x);
+    void set3f(GLuint program, GLint location, float x, float y, float z);
+    void set4f(GLuint program, GLint location, float x, float y, float z, float w);
+
+    // Forget what was written to a program, for instance when it is relinked or deleted
+    void invalidate(GLuint program);
+    // Forget everything
+    void invalidate();
+
+    // Statistics
+    unsigned long getIssuedCount() const;
+    unsigned long getSkippedCount() const;
+    void resetCounters();
+
+private:
+    struct Entry
+    {
+        int components;
+        unsigned int bits[4];
+    };
+
+    // Returns true if the value differs from the cached one (and so has to be sent to GL)
+    bool update(GLuint program, GLint location, int components, const void *values);
+
+    // Guards the entries and the statistics
+    mutable std::mutex mutex;
+    std::unordered_map<unsigned long long, Entry> entries;
+    unsigned long issued;
+    unsigned long skipped;
+};
@@ -0,0 +1,75 @@
+#include "HeadlessContext.h"
+#include "BzfGL.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <stdio.h>
+
+static void* getProcAddress(const char *name)
+{
+    return (void*)eglGetProcAddress(name);
+}
+
+bool createHeadlessContext()
+{
+    EGLDisplay display = EGL_NO_DISPLAY;
+
+    // Prefer a surfaceless display so that no window system is needed at all
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay != nullptr)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+    {
+        fprintf(stderr, "Error: Unable to initialize EGL (0x%x)\n", eglGetError());
+        return false;
+    }
+
+#ifdef USE_GLES2
+    eglBindAPI(EGL_OPENGL_ES_API);
+    const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT, EGL_NONE };
+    const EGLint contextAttributes[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+#else
+    eglBindAPI(EGL_OPENGL_API);
+    const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    const EGLint contextAttributes[] = { EGL_NONE };
+#endif
+
+    // We only ever draw into framebuffer objects, so a config is only needed for the pbuffer fallback
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+
+    EGLContext context = eglCreateContext(display, configCount > 0 ? config : nullptr, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT)
+    {
+        fprintf(stderr, "Error: Unable to create an EGL context (0x%x)\n", eglGetError());
+        return false;
+    }
+
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+    {
+        // No EGL_KHR_surfaceless_context, so fall back to a tiny pbuffer
+        const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        EGLSurface surface = (configCount > 0) ? eglCreatePbufferSurface(display, config, pbufferAttributes) : EGL_NO_SURFACE;
+        if (surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context))
+        {
+            fprintf(stderr, "Error: Unable to make the EGL context current (0x%x)\n", eglGetError());
+            return false;
+        }
+    }
+
+    BzfGLCapabilities capabilities;
+    if (!loadGLFunctions(getProcAddress, capabilities))
+    {
+        fprintf(stderr, "Error: Unable to load the OpenGL functions\n");
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Create a surfaceless EGL context and make it current on the calling thread, so that the renderer can be exercised
+// without a window system. Rendering has to go into framebuffer objects. Returns false (after reporting why) if no
+// context could be made.
+bool createHeadlessContext();
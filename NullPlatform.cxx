@@ -0,0 +1,482 @@
+#include "NullPlatform.h"
+#include "BzfMetrics.h"
+#include "BzfProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+///////////////////////////////////////////////////////////
+// Platform
+///////////////////////////////////////////////////////////
+
+const BzfResolution NullPlatform::nullResolution = { 1920, 1080, 60 };
+
+NullPlatform::NullPlatform() : textInput(false)
+{
+}
+
+NullPlatform::~NullPlatform()
+{
+    shutdownJobSystem();
+
+    for (auto window : windows)
+        delete window;
+    BzfMetrics::get().gauge("windows")->add(-(double)windows.size());
+}
+
+BzfWindow* NullPlatform::createWindow(int width, int height, BzfMonitor* /*monitor*/, int positionX, int positionY)
+{
+    NullWindow* window = new NullWindow(this, width, height, positionX, positionY);
+    windows.push_back(window);
+    BzfMetrics::get().gauge("windows")->add(1);
+    return window;
+}
+
+BzfWindow* NullPlatform::createWindow(BzfResolution resolution, BzfMonitor* /*monitor*/)
+{
+    NullWindow* window = new NullWindow(this, resolution);
+    windows.push_back(window);
+    BzfMetrics::get().gauge("windows")->add(1);
+    return window;
+}
+
+void NullPlatform::destroyWindow(BzfWindow* window)
+{
+    auto found = std::find(windows.begin(), windows.end(), window);
+    if (found == windows.end())
+        return;
+
+    windows.erase(found);
+    delete window;
+    BzfMetrics::get().gauge("windows")->add(-1);
+}
+
+BzfAudio* NullPlatform::getAudio()
+{
+    return nullptr;
+}
+
+BzfJoystick* NullPlatform::getJoystick()
+{
+    return nullptr;
+}
+
+bool NullPlatform::isGameRunning() const
+{
+    for (auto window : windows)
+    {
+        if (window->shouldClose())
+            return false;
+    }
+
+    return true;
+}
+
+BzfMonitor* NullPlatform::getPrimaryMonitor() const
+{
+    BzfMonitor* monitor = new BzfMonitor;
+    monitor->name = "Null";
+    return monitor;
+}
+
+std::vector<BzfMonitor*> NullPlatform::getMonitors() const
+{
+    return std::vector<BzfMonitor*>(1, getPrimaryMonitor());
+}
+
+BzfResolution NullPlatform::getCurrentResolution(BzfMonitor* /*monitor*/) const
+{
+    return nullResolution;
+}
+
+std::vector<BzfResolution> NullPlatform::getResolutions(BzfMonitor* /*monitor*/) const
+{
+    return std::vector<BzfResolution>(1, nullResolution);
+}
+
+void NullPlatform::GLSetVersion(BzfGLProfile /*profile*/, unsigned short /*majorVersion*/,
+                                unsigned short /*minorVersion*/) const
+{
+}
+
+void NullPlatform::GLSetRGBA(unsigned short /*red*/, unsigned short /*green*/, unsigned short /*blue*/,
+                             unsigned short /*alpha*/) const
+{
+}
+
+void NullPlatform::GLSetContextFlags(int /*flags*/) const
+{
+}
+
+void NullPlatform::pollEvents()
+{
+    BZF_PROFILE_ZONE("NullPlatform::pollEvents");
+    static BzfCounter *eventCount = BzfMetrics::get().counter("events");
+
+    // Take the whole queue at once, so that the callbacks can inject more events (for the next poll) without
+    // deadlocking
+    std::deque<std::function<void()>> delivered;
+    {
+        std::lock_guard<std::mutex> lock(eventMutex);
+        delivered.swap(events);
+    }
+
+    if (!delivered.empty())
+        eventCount->add(delivered.size());
+    for (auto &event : delivered)
+        event();
+}
+
+void NullPlatform::waitEvents(double timeout)
+{
+    {
+        std::unique_lock<std::mutex> lock(eventMutex);
+        eventInjected.wait_for(lock, std::chrono::duration<double>(timeout), [this]()
+        {
+            return !events.empty();
+        });
+    }
+
+    pollEvents();
+}
+
+bool NullPlatform::hasVisibleWindow() const
+{
+    for (auto window : windows)
+    {
+        if (!window->isHidden() && !window->isMinimized())
+            return true;
+    }
+
+    return false;
+}
+
+void NullPlatform::startTextInput()
+{
+    textInput = true;
+}
+
+void NullPlatform::stopTextInput()
+{
+    textInput = false;
+}
+
+bool NullPlatform::isTextInput()
+{
+    return textInput;
+}
+
+void NullPlatform::inject(std::function<void()> event)
+{
+    {
+        std::lock_guard<std::mutex> lock(eventMutex);
+        events.push_back(event);
+    }
+    eventInjected.notify_one();
+}
+
+size_t NullPlatform::getPendingEventCount() const
+{
+    std::lock_guard<std::mutex> lock(eventMutex);
+    return events.size();
+}
+
+NullWindow* NullPlatform::findWindow(const BzfWindow* window) const
+{
+    auto found = std::find(windows.begin(), windows.end(), window);
+    return found != windows.end() ? *found : nullptr;
+}
+
+void NullPlatform::injectKey(BzfWindow* window, BzfKey key, BzfKeyAction action, int mods)
+{
+    inject([this, window, key, action, mods]()
+    {
+        if (findWindow(window) != nullptr && keyCallback != nullptr)
+            keyCallback(this, window, key, action, mods);
+    });
+}
+
+void NullPlatform::injectText(BzfWindow* window, const char* text)
+{
+    // The callbacks take the text in a buffer of their own
+    std::string copy(text);
+    inject([this, window, copy]()
+    {
+        if (findWindow(window) == nullptr || textCallback == nullptr || !textInput)
+            return;
+        char buffer[32] = {0};
+        strncpy(buffer, copy.c_str(), sizeof(buffer) - 1);
+        textCallback(this, window, buffer);
+    });
+}
+
+void NullPlatform::injectCursorPos(BzfWindow* window, double x, double y)
+{
+    inject([this, window, x, y]()
+    {
+        NullWindow* nullWindow = findWindow(window);
+        if (nullWindow == nullptr)
+            return;
+        nullWindow->setMousePosition(x, y);
+        if (cursorPosCallback != nullptr)
+            cursorPosCallback(this, window, x, y);
+    });
+}
+
+void NullPlatform::injectMouseButton(BzfWindow* window, BzfMouseButton button, BzfButtonAction action, int mods)
+{
+    inject([this, window, button, action, mods]()
+    {
+        if (findWindow(window) != nullptr && mouseButtonCallback != nullptr)
+            mouseButtonCallback(this, window, button, action, mods);
+    });
+}
+
+void NullPlatform::injectScroll(BzfWindow* window, double x, double y)
+{
+    inject([this, window, x, y]()
+    {
+        if (findWindow(window) != nullptr && scrollCallback != nullptr)
+            scrollCallback(this, window, x, y);
+    });
+}
+
+void NullPlatform::injectJoystickButton(BzfJoyButton button, BzfButtonAction action)
+{
+    inject([this, button, action]()
+    {
+        if (!windows.empty() && joystickButtonCallback != nullptr)
+            joystickButtonCallback(this, windows.front(), button, action);
+    });
+}
+
+void NullPlatform::injectJoystickHat(BzfJoyHat hat, BzfJoyHatDirection direction)
+{
+    inject([this, hat, direction]()
+    {
+        if (!windows.empty() && joystickHatCallback != nullptr)
+            joystickHatCallback(this, windows.front(), hat, direction);
+    });
+}
+
+void NullPlatform::injectResize(BzfWindow* window, int width, int height)
+{
+    inject([this, window, width, height]()
+    {
+        NullWindow* nullWindow = findWindow(window);
+        if (nullWindow == nullptr)
+            return;
+        nullWindow->resize(width, height);
+        // There is no HiDPI scaling, so the viewport is the window size
+        for (auto callback : resizeCallbacks)
+            callback(this, window, width, height);
+    });
+}
+
+void NullPlatform::injectMove(BzfWindow* window, int x, int y)
+{
+    inject([this, window, x, y]()
+    {
+        NullWindow* nullWindow = findWindow(window);
+        if (nullWindow == nullptr)
+            return;
+        nullWindow->move(x, y);
+        for (auto callback : moveCallbacks)
+            callback(this, window, x, y);
+    });
+}
+
+void NullPlatform::injectMinimize(const BzfWindow* window, bool minimized)
+{
+    inject([this, window, minimized]()
+    {
+        NullWindow* nullWindow = findWindow(window);
+        if (nullWindow != nullptr)
+            nullWindow->minimize(minimized);
+    });
+}
+
+void NullPlatform::injectClose(BzfWindow* window)
+{
+    inject([this, window]()
+    {
+        NullWindow* nullWindow = findWindow(window);
+        if (nullWindow != nullptr)
+            nullWindow->requestClose();
+    });
+}
+
+///////////////////////////////////////////////////////////
+// Window
+///////////////////////////////////////////////////////////
+
+NullWindow::NullWindow(NullPlatform* _platform, int width, int height, int positionX, int positionY) :
+    platform(_platform), closeRequested(false), gamma(1.0f), mouseRelative(false), mouseX(0.0), mouseY(0.0),
+    mouseConfinementMode(BZF_MOUSE_CONFINED_NONE), minWidth(0), minHeight(0)
+{
+    setWindowed(width, height, nullptr, positionX, positionY);
+}
+
+NullWindow::NullWindow(NullPlatform* _platform, BzfResolution resolution) : platform(_platform),
+    closeRequested(false), gamma(1.0f), mouseRelative(false), mouseX(0.0), mouseY(0.0),
+    mouseConfinementMode(BZF_MOUSE_CONFINED_NONE), minWidth(0), minHeight(0)
+{
+    setFullscreen(resolution);
+}
+
+NullWindow::~NullWindow()
+{
+}
+
+void NullWindow::setWindowState(int width, int height, int x, int y, bool fullscreen)
+{
+    BzfWindowState newState = getState();
+    newState.width = newState.drawableWidth = std::max(width, minWidth);
+    newState.height = newState.drawableHeight = std::max(height, minHeight);
+    newState.x = x;
+    newState.y = y;
+    newState.fullscreen = fullscreen;
+    setState(newState);
+}
+
+bool NullWindow::setWindowed(int width, int height, BzfMonitor* /*monitor*/, int x, int y)
+{
+    // Negative positions mean centered, as with the other backends
+    if (x < 0)
+        x = (NullPlatform::nullResolution.width - width) / 2;
+    if (y < 0)
+        y = (NullPlatform::nullResolution.height - height) / 2;
+    setWindowState(width, height, x, y, false);
+    return true;
+}
+
+bool NullWindow::setFullscreen(BzfResolution resolution, BzfMonitor* /*monitor*/)
+{
+    setWindowState(resolution.width, resolution.height, 0, 0, true);
+    return true;
+}
+
+void NullWindow::iconify() const
+{
+    // Like a window manager, which reports it afterwards
+    platform->injectMinimize(this, true);
+}
+
+void NullWindow::setMinSize(int width, int height)
+{
+    minWidth = width;
+    minHeight = height;
+    BzfWindowState current = getState();
+    setWindowState(current.width, current.height, current.x, current.y, current.fullscreen);
+}
+
+void NullWindow::setTitle(const char* /*title*/)
+{
+}
+
+void NullWindow::setIcon(BzfIcon* /*icon*/)
+{
+}
+
+void NullWindow::setMouseRelative(bool relative)
+{
+    mouseRelative = relative;
+}
+
+void NullWindow::setMousePosition(double x, double y)
+{
+    mouseX = x;
+    mouseY = y;
+}
+
+void NullWindow::getMousePosition(double &x, double &y) const
+{
+    x = mouseX;
+    y = mouseY;
+}
+
+bool NullWindow::supportsMouseConfinement()
+{
+    return true;
+}
+
+bool NullWindow::setConfineMouse(BzfMouseConfinement mode, double /*x1*/, double /*y1*/, double /*x2*/,
+                                 double /*y2*/)
+{
+    mouseConfinementMode = mode;
+    return true;
+}
+
+BzfMouseConfinement NullWindow::getConfineMouse()
+{
+    return mouseConfinementMode;
+}
+
+BzfSwapPolicy NullWindow::setSwapPolicy(BzfSwapPolicy policy) const
+{
+    swapPolicy = policy;
+    return swapPolicy;
+}
+
+void NullWindow::makeContextCurrent() const
+{
+}
+
+void NullWindow::releaseContext() const
+{
+}
+
+void NullWindow::swapBuffers() const
+{
+    // Not recorded as a swap, since the latency and frames in flight measurements would need a context
+}
+
+void NullWindow::setGamma(float _gamma)
+{
+    gamma = _gamma;
+}
+
+float NullWindow::getGamma()
+{
+    return gamma;
+}
+
+bool NullWindow::hasGammaControl() const
+{
+    return false;
+}
+
+NullPlatform* NullWindow::getPlatform() const
+{
+    return platform;
+}
+
+bool NullWindow::shouldClose() const
+{
+    return closeRequested;
+}
+
+void NullWindow::requestClose()
+{
+    closeRequested = true;
+}
+
+void NullWindow::resize(int width, int height)
+{
+    BzfWindowState current = getState();
+    setWindowState(width, height, current.x, current.y, current.fullscreen);
+}
+
+void NullWindow::minimize(bool minimized)
+{
+    BzfWindowState newState = getState();
+    newState.minimized = minimized;
+    setState(newState);
+}
+
+void NullWindow::move(int x, int y)
+{
+    BzfWindowState current = getState();
+    setWindowState(current.width, current.height, x, y, current.fullscreen);
+}
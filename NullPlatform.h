@@ -0,0 +1,158 @@
+#pragma once
+
+#include "BzfPlatform.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class NullWindow;
+
+// A platform without a window system, for clients that run headless, like the bots of a server load test. Its windows
+// only keep their state and have no OpenGL context, and the only input is what gets injected into it.
+//
+// Any number of instances can run in one process, each on a thread of its own. The only thing they share is the
+// process-wide BzfMetrics, whose "windows" gauge and "events" counter add up the windows and events of all of them.
+// Events can be injected from any thread, and are delivered to the callbacks by the next pollEvents() or waitEvents()
+// on the thread that runs the platform. Everything else has to be called from that thread.
+//
+// This is not the backend of BzfBackend.h, so its objects must not be passed to bzfBackend().
+class NullPlatform final : public BzfPlatform
+{
+public:
+    NullPlatform();
+    ~NullPlatform();
+
+    BzfWindow* createWindow(int width, int height, BzfMonitor* monitor = nullptr, int positionX = -1, int positionY = -1);
+    BzfWindow* createWindow(BzfResolution resolution, BzfMonitor* monitor = nullptr);
+    void destroyWindow(BzfWindow* window);
+
+    // Audio
+    BzfAudio* getAudio();
+
+    // Joysticks / Game Controllers
+    BzfJoystick* getJoystick();
+
+    bool isGameRunning() const;
+
+    // Monitors
+    // There is a single monitor, which runs at nullResolution
+    BzfMonitor* getPrimaryMonitor() const;
+    std::vector<BzfMonitor*> getMonitors() const;
+    BzfResolution getCurrentResolution(BzfMonitor* monitor = nullptr) const;
+    std::vector<BzfResolution> getResolutions(BzfMonitor* monitor = nullptr) const;
+
+    // OpenGL Attributes
+    // There are no contexts, so these do nothing
+    void GLSetVersion(BzfGLProfile profile, unsigned short majorVersion, unsigned short minorVersion) const;
+    void GLSetRGBA(unsigned short red, unsigned short green, unsigned short blue, unsigned short alpha) const;
+    void GLSetContextFlags(int flags) const;
+
+    // Events
+    // Deliver the events that were injected so far
+    void pollEvents();
+    void waitEvents(double timeout);
+
+    bool hasVisibleWindow() const;
+
+    void startTextInput();
+    void stopTextInput();
+    bool isTextInput();
+
+    // Event injection, from any thread. Events for a window that is destroyed before they are delivered are dropped.
+    void injectKey(BzfWindow* window, BzfKey key, BzfKeyAction action, int mods = 0);
+    // Dropped unless text input is on when the event is delivered
+    void injectText(BzfWindow* window, const char* text);
+    void injectCursorPos(BzfWindow* window, double x, double y);
+    void injectMouseButton(BzfWindow* window, BzfMouseButton button, BzfButtonAction action, int mods = 0);
+    void injectScroll(BzfWindow* window, double x, double y);
+    // Joystick events are reported for the first window, like the other backends do
+    void injectJoystickButton(BzfJoyButton button, BzfButtonAction action);
+    void injectJoystickHat(BzfJoyHat hat, BzfJoyHatDirection direction);
+    // Change the window's size or position as a window manager would, and call the callbacks
+    void injectResize(BzfWindow* window, int width, int height);
+    void injectMove(BzfWindow* window, int x, int y);
+    // Minimize or restore the window
+    void injectMinimize(const BzfWindow* window, bool minimized);
+    // Ask the window to close, after which isGameRunning() returns false
+    void injectClose(BzfWindow* window);
+    // Number of injected events that were not delivered yet
+    size_t getPendingEventCount() const;
+
+    static const BzfResolution nullResolution;
+
+private:
+    std::vector<NullWindow*> windows;
+    bool textInput;
+
+    mutable std::mutex eventMutex;
+    std::condition_variable eventInjected;
+    std::deque<std::function<void()>> events;
+
+    void inject(std::function<void()> event);
+    NullWindow* findWindow(const BzfWindow* window) const;
+};
+
+class NullWindow final : public BzfWindow
+{
+public:
+    NullWindow(NullPlatform* platform, int width, int height, int positionX = -1, int positionY = -1);
+    NullWindow(NullPlatform* platform, BzfResolution resolution);
+    ~NullWindow();
+
+    // Fullscreen/Windowed
+    bool setWindowed(int width, int height, BzfMonitor* monitor = nullptr, int x = -1, int y = -1);
+    bool setFullscreen(BzfResolution resolution, BzfMonitor* monitor = nullptr);
+    void iconify() const;
+    void setMinSize(int width, int height);
+    void setTitle(const char *title);
+    void setIcon(BzfIcon *icon);
+
+    // Mouse
+    void setMouseRelative(bool relative);
+    void setMousePosition(double x, double y);
+    bool supportsMouseConfinement();
+    bool setConfineMouse(BzfMouseConfinement mode, double x1 = 0, double y1 = 0, double x2 = 0, double y2 = 0);
+    BzfMouseConfinement getConfineMouse();
+
+    // Swap policy
+    // Any policy is granted, as nothing waits for a display
+    BzfSwapPolicy setSwapPolicy(BzfSwapPolicy policy) const;
+
+    // Drawing/context
+    // There is no context, so nothing can be drawn and these do nothing
+    void makeContextCurrent() const;
+    void releaseContext() const;
+    void swapBuffers() const;
+
+    // Gamma control
+    void setGamma(float gamma);
+    float getGamma();
+    bool hasGammaControl() const;
+
+    // Null window specific methods
+    NullPlatform* getPlatform() const;
+    bool shouldClose() const;
+    void requestClose();
+    // Change the size or position as a window manager would
+    void resize(int width, int height);
+    void move(int x, int y);
+    void minimize(bool minimized);
+    // Where the cursor was last put, by setMousePosition() or an injected event
+    void getMousePosition(double &x, double &y) const;
+
+private:
+    NullPlatform* platform;
+    bool closeRequested;
+    float gamma;
+    bool mouseRelative;
+    double mouseX;
+    double mouseY;
+    BzfMouseConfinement mouseConfinementMode;
+    int minWidth;
+    int minHeight;
+
+    void setWindowState(int width, int height, int x, int y, bool fullscreen);
+};
@@ -0,0 +1,536 @@
+// Headless micro-benchmarks for the platform layer
+//
+// Times the hot paths of the backend that the benchmark is built against: key and modifier translation, event
+// dispatch through the BzfPlatform callbacks, the audio command queue, audio frame conversion, WAV loading and building
+// the GLHelloWorld shader program. The SDL dummy video and audio drivers are selected unless SDL_VIDEODRIVER or
+// SDL_AUDIODRIVER is already set, and the shader is built in a surfaceless EGL context, so no display or sound card is
+// needed. Results are printed as a table and written as JSON so that runs can be compared.
+//
+// The frame benchmarks make the calls that the main loop makes into the platform every frame, once through the
+// interfaces and once through the backend types of BzfBackend.h. These only differ in a build with
+// ENABLE_STATIC_DISPATCH. Since the dummy video driver has no OpenGL, the window calls are only part of it when -window
+// is given, which needs a display.
+//
+// The null platforms benchmark runs a number of bots (32 unless -bots is given), each on a thread with a NullPlatform of
+// its own, like a server load test would, and times delivering the input that is injected into them.
+//
+// Usage: platformBenchmark [-iterations N] [-output results.json] [-shader name.frag] [-window] [-bots N]
+
+#include "PlatformFactory.h"
+#include "BzfBackend.h"
+#include "BzfClock.h"
+#include "BzfJobSystem.h"
+#include "GLHelloWorld.h"
+#include "HeadlessContext.h"
+#include "NullPlatform.h"
+
+#ifdef USE_GLFW
+#include "GLFWPlatform.h"
+#else
+#include "SDL2Platform.h"
+#endif
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+struct BenchmarkResult
+{
+    std::string name;
+    unsigned long operations;
+    double seconds;
+};
+
+static std::vector<BenchmarkResult> results;
+
+#ifdef BZF_STATIC_DISPATCH
+static const char *dispatch = "static";
+#else
+static const char *dispatch = "virtual";
+#endif
+
+// Benchmarked work is folded into this so that the compiler can not discard it
+static volatile unsigned long sink = 0;
+
+static void addResult(const char *name, unsigned long operations, uint64_t ticks)
+{
+    double seconds = BzfClock::toSeconds(ticks);
+    results.push_back({ name, operations, seconds });
+    printf("%-20s %12lu %14.1f\n", name, operations, (operations > 0) ? seconds * 1e9 / operations : 0.0);
+}
+
+template<typename Body>
+static void measure(const char *name, unsigned long operations, Body body)
+{
+    uint64_t start = BzfClock::now();
+    body();
+    addResult(name, operations, BzfClock::now() - start);
+}
+
+static void skip(const char *name, const char *reason)
+{
+    printf("%-20s %12s %14s  (%s)\n", name, "-", "-", reason);
+}
+
+static void benchmarkKeys(unsigned long iterations)
+{
+#ifdef USE_GLFW
+    std::vector<int> keys;
+    for (int key = GLFW_KEY_UNKNOWN; key <= GLFW_KEY_LAST; ++key)
+        keys.push_back(key);
+
+    measure("keyFromGLFW", iterations * keys.size(), [&]()
+    {
+        unsigned long sum = 0;
+        for (unsigned long i = 0; i < iterations; ++i)
+            for (auto key : keys)
+                sum += GLFWPlatform::keyFromGLFW(key);
+        sink += sum;
+    });
+
+    // Shift, control, alt and super
+    const int modCombinations = 16;
+    measure("modsFromGLFW", iterations * modCombinations, [&]()
+    {
+        unsigned long sum = 0;
+        for (unsigned long i = 0; i < iterations; ++i)
+            for (int mods = 0; mods < modCombinations; ++mods)
+                sum += GLFWPlatform::modsFromGLFW(mods);
+        sink += sum;
+    });
+#else
+    // Printable keys are their own keycodes, everything else is a scancode with a flag set
+    std::vector<SDL_Keycode> keys;
+    for (int key = 0; key < 128; ++key)
+        keys.push_back(key);
+    for (int scancode = 0; scancode < SDL_NUM_SCANCODES; ++scancode)
+        keys.push_back(scancode | SDLK_SCANCODE_MASK);
+
+    measure("keyFromSDL", iterations * keys.size(), [&]()
+    {
+        unsigned long sum = 0;
+        for (unsigned long i = 0; i < iterations; ++i)
+            for (auto key : keys)
+                sum += SDL2Platform::keyFromSDL(key);
+        sink += sum;
+    });
+
+    // Both shifts, both controls, both alts and both GUI keys
+    const int modCombinations = 4096;
+    measure("modsFromSDL", (iterations / 16 + 1) * modCombinations, [&]()
+    {
+        unsigned long sum = 0;
+        for (unsigned long i = 0; i < iterations / 16 + 1; ++i)
+            for (int mods = 0; mods < modCombinations; ++mods)
+                sum += SDL2Platform::modsFromSDL(mods);
+        sink += sum;
+    });
+#endif
+
+    measure("getKeyName", iterations * (BZF_KEY_LAST + 1), [&]()
+    {
+        unsigned long sum = 0;
+        for (unsigned long i = 0; i < iterations; ++i)
+            for (int key = BZF_KEY_UNKNOWN; key <= BZF_KEY_LAST; ++key)
+            {
+                const char *name = getKeyName((BzfKey)key);
+                if (name != nullptr)
+                    sum += name[0];
+            }
+        sink += sum;
+    });
+}
+
+static void benchmarkEvents(BzfPlatform *platform, unsigned long events)
+{
+#ifdef USE_GLFW
+    (void)platform;
+    (void)events;
+    skip("pollEvents", "GLFW can not queue synthetic events");
+#else
+    unsigned long received = 0;
+    platform->setKeyCallback([&](BzfPlatform*, BzfWindow*, BzfKey, BzfKeyAction, int)
+    {
+        ++received;
+    });
+    platform->setCursorPosCallback([&](BzfPlatform*, BzfWindow*, double, double)
+    {
+        ++received;
+    });
+    platform->setMouseButtonCallback([&](BzfPlatform*, BzfWindow*, BzfMouseButton, BzfButtonAction, int)
+    {
+        ++received;
+    });
+    platform->setScrollCallback([&](BzfPlatform*, BzfWindow*, double, double)
+    {
+        ++received;
+    });
+
+    // A mix of the events that arrive most often while playing. They carry no window ID, so no window is needed.
+    SDL_Event templates[4];
+    SDL_memset(templates, 0, sizeof(templates));
+    templates[0].type = SDL_KEYDOWN;
+    templates[0].key.state = SDL_PRESSED;
+    templates[0].key.keysym.sym = SDLK_a;
+    templates[1].type = SDL_MOUSEMOTION;
+    templates[1].motion.x = 320;
+    templates[1].motion.y = 240;
+    templates[2].type = SDL_MOUSEBUTTONDOWN;
+    templates[2].button.button = 1;
+    templates[2].button.state = SDL_PRESSED;
+    templates[3].type = SDL_MOUSEWHEEL;
+    templates[3].wheel.y = 1;
+
+    // Flush whatever the video driver queued on startup so it is not counted
+    platform->pollEvents();
+
+    // Stay well below the capacity of the SDL event queue
+    const unsigned long batchSize = 256;
+    unsigned long pushed = 0;
+    uint64_t ticks = 0;
+    while (pushed < events)
+    {
+        for (unsigned long i = 0; i < batchSize && pushed < events; ++i, ++pushed)
+            SDL_PushEvent(&templates[pushed % 4]);
+
+        // Only the dispatch is timed, not queueing the events
+        uint64_t start = BzfClock::now();
+        platform->pollEvents();
+        ticks += BzfClock::now() - start;
+    }
+
+    platform->setKeyCallback(nullptr);
+    platform->setCursorPosCallback(nullptr);
+    platform->setMouseButtonCallback(nullptr);
+    platform->setScrollCallback(nullptr);
+
+    if (received != events)
+        fprintf(stderr, "Warning: Dispatched %lu of %lu events\n", received, events);
+    addResult("pollEvents", received, ticks);
+#endif
+}
+
+// One bot of a load test, with a platform of its own, getting input injected a frame's worth at a time
+static void runBot(unsigned long events, std::atomic<unsigned long> &received)
+{
+    NullPlatform platform;
+    BzfWindow *window = platform.createWindow(640, 480);
+    unsigned long count = 0;
+    platform.setKeyCallback([&](BzfPlatform*, BzfWindow*, BzfKey, BzfKeyAction, int)
+    {
+        ++count;
+    });
+
+    const unsigned long eventsPerFrame = 16;
+    for (unsigned long i = 0; i < events; ++i)
+    {
+        platform.injectKey(window, BZF_KEY_A, (i % 2 == 0) ? BZF_KEY_PRESSED : BZF_KEY_RELEASED);
+        if (i % eventsPerFrame == eventsPerFrame - 1)
+            platform.pollEvents();
+    }
+    platform.pollEvents();
+
+    received += count;
+}
+
+static void benchmarkNullPlatforms(unsigned long events, unsigned int bots)
+{
+    std::atomic<unsigned long> received(0);
+    measure("null platforms", events * bots, [&]()
+    {
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < bots; ++i)
+            threads.push_back(std::thread(runBot, events, std::ref(received)));
+        for (auto &thread : threads)
+            thread.join();
+    });
+
+    if (received != events * bots)
+        fprintf(stderr, "Warning: Delivered %lu of %lu injected events\n", received.load(), events * bots);
+}
+
+// Swapping the buffers is left out, as what that costs is up to the driver
+template<typename Platform, typename Window, typename Joystick>
+static void benchmarkFrames(const char *name, Platform *platform, Window *window, Joystick *joystick,
+                            unsigned long frames)
+{
+    measure(name, frames, [&]()
+    {
+        double sum = 0.0;
+        for (unsigned long i = 0; i < frames; ++i)
+        {
+            sum += platform->getGameTime();
+            if (window != nullptr)
+            {
+                int width, height;
+                window->makeContextCurrent();
+                window->getWindowSize(width, height);
+                sum += width;
+            }
+            if (joystick != nullptr)
+                sum += joystick->getAxis(0) + joystick->getAxis(1);
+        }
+        sink += (unsigned long)sum;
+    });
+}
+
+static void benchmarkDispatch(BzfPlatform *platform, bool withWindow, unsigned long frames)
+{
+    BzfWindow *window = withWindow ? platform->createWindow(64, 64) : nullptr;
+    BzfJoystick *joystick = platform->getJoystick();
+
+    benchmarkFrames<BzfPlatform, BzfWindow, BzfJoystick>("frame (virtual)", platform, window, joystick, frames);
+    benchmarkFrames<BzfBackendPlatform, BzfBackendWindow, BzfBackendJoystick>("frame (static)", bzfBackend(platform),
+            bzfBackend(window), bzfBackend(joystick), frames);
+
+    if (window != nullptr)
+        platform->destroyWindow(window);
+}
+
+static void writeLittleEndian(FILE *file, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+        fputc((value >> (i * 8)) & 0xff, file);
+}
+
+// Write a mono 16 bit sine wave. Its format differs from the device format, so loading it includes a conversion.
+static bool writeTestWAV(const char *filename, int rate, int seconds)
+{
+    FILE *file = fopen(filename, "wb");
+    if (file == nullptr)
+        return false;
+
+    uint32_t samples = rate * seconds;
+    uint32_t dataSize = samples * 2;
+
+    fputs("RIFF", file);
+    writeLittleEndian(file, 36 + dataSize, 4);
+    fputs("WAVEfmt ", file);
+    writeLittleEndian(file, 16, 4);
+    writeLittleEndian(file, 1, 2); // PCM
+    writeLittleEndian(file, 1, 2); // Channels
+    writeLittleEndian(file, rate, 4);
+    writeLittleEndian(file, rate * 2, 4); // Bytes per second
+    writeLittleEndian(file, 2, 2); // Bytes per frame
+    writeLittleEndian(file, 16, 2); // Bits per sample
+    fputs("data", file);
+    writeLittleEndian(file, dataSize, 4);
+    for (uint32_t i = 0; i < samples; ++i)
+        writeLittleEndian(file, (uint16_t)(int16_t)(sin(i * 440.0 * 2.0 * M_PI / rate) * 16000.0), 2);
+
+    bool success = (ferror(file) == 0);
+    fclose(file);
+    return success;
+}
+
+static void benchmarkAudio(BzfPlatform *platform, unsigned long iterations)
+{
+    BzfAudio *audio = platform->getAudio();
+    if (audio == nullptr)
+    {
+        skip("audio", "the backend has no audio support");
+        return;
+    }
+    // The device is left paused, so the audio callback never drains the command queue or the output buffer
+    if (!audio->openDevice(nullptr))
+    {
+        skip("audio", "no audio device could be opened");
+        return;
+    }
+
+    // The size of a typical sound command
+    char command[16];
+    memset(command, 0, sizeof(command));
+    unsigned long commands = iterations * 10;
+    measure("soundCommand", commands, [&]()
+    {
+        unsigned long sum = 0;
+        for (unsigned long i = 0; i < commands; ++i)
+        {
+            command[0] = (char)i;
+            audio->writeSoundCommand(command, sizeof(command));
+            if (audio->readSoundCommand(command, sizeof(command)))
+                sum += command[0];
+        }
+        sink += sum;
+    });
+
+    // Include samples outside of the 16 bit range, so that clamping is exercised as well
+    int chunkFrames = audio->getAudioBufferChunkSize();
+    std::vector<float> samples(chunkFrames * 2);
+    for (size_t i = 0; i < samples.size(); ++i)
+        samples[i] = sinf(i * 0.01f) * 40000.0f;
+
+    unsigned long chunks = iterations / 100 + 1;
+    measure("writeAudioFrames", chunks * chunkFrames, [&]()
+    {
+        for (unsigned long i = 0; i < chunks; ++i)
+            audio->writeAudioFrames(samples.data(), chunkFrames);
+    });
+
+    const char *filename = "platformBenchmark.wav";
+    if (!writeTestWAV(filename, 44100, 1))
+    {
+        skip("doReadSound", "the test sound could not be written");
+        audio->closeDevice();
+        return;
+    }
+
+    unsigned long loads = iterations / 1000 + 1;
+    measure("doReadSound", loads, [&]()
+    {
+        for (unsigned long i = 0; i < loads; ++i)
+        {
+            int frames, rate;
+            float *sound = audio->doReadSound(filename, frames, rate);
+            if (sound != nullptr)
+                sink += frames;
+            delete[] sound;
+        }
+    });
+
+    // The same loads spread over the workers of the job system, as a game loading its sounds would do it
+    BzfJobSystem *jobs = platform->getJobSystem();
+    measure("doReadSound on jobs", loads, [&]()
+    {
+        std::atomic<unsigned long> frameSum(0);
+        std::vector<BzfJobHandle> reads;
+        for (unsigned long i = 0; i < loads; ++i)
+        {
+            reads.push_back(jobs->submit([&]()
+            {
+                int frames, rate;
+                float *sound = audio->doReadSound(filename, frames, rate);
+                if (sound != nullptr)
+                    frameSum += frames;
+                delete[] sound;
+            }));
+        }
+        jobs->wait(jobs->submit([]() {}, reads));
+        sink += frameSum;
+    });
+
+    remove(filename);
+    audio->closeDevice();
+}
+
+static void benchmarkShaderBuild(const char *shader, unsigned long builds)
+{
+    if (!createHeadlessContext())
+    {
+        skip("GLHelloWorld", "no headless OpenGL context");
+        return;
+    }
+
+    // The first build loads the driver's compiler, which is not what we want to measure
+    {
+        GLHelloWorld warmup(shader, 64, 64);
+        glFinish();
+    }
+
+    measure("GLHelloWorld", builds, [&]()
+    {
+        for (unsigned long i = 0; i < builds; ++i)
+        {
+            GLHelloWorld hw(shader, 64, 64);
+            glFinish();
+        }
+    });
+}
+
+static bool writeJSON(const char *filename, const char *backend)
+{
+    FILE *file = fopen(filename, "w");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Could not write the results to %s\n", filename);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"backend\": \"%s\",\n  \"dispatch\": \"%s\",\n  \"results\": [", backend, dispatch);
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchmarkResult &result = results[i];
+        fprintf(file, "%s\n    { \"name\": \"%s\", \"operations\": %lu, \"seconds\": %.9f, \"nsPerOperation\": %.3f }",
+                i == 0 ? "" : ",", result.name.c_str(), result.operations, result.seconds,
+                (result.operations > 0) ? result.seconds * 1e9 / result.operations : 0.0);
+    }
+    fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long iterations = 10000;
+    const char *output = "platformBenchmark.json";
+    const char *shader = "Mss3WN.frag";
+    bool withWindow = false;
+    unsigned int bots = 32;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-iterations") == 0 && i + 1 < argc)
+            iterations = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "-output") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else if (strcmp(argv[i], "-shader") == 0 && i + 1 < argc)
+            shader = argv[++i];
+        else if (strcmp(argv[i], "-window") == 0)
+            withWindow = true;
+        else if (strcmp(argv[i], "-bots") == 0 && i + 1 < argc)
+            bots = strtoul(argv[++i], nullptr, 10);
+        else
+        {
+            printf("Usage: %s [-iterations N] [-output results.json] [-shader name.frag] [-window] [-bots N]\n",
+                   argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (iterations < 1)
+        iterations = 1;
+    if (bots < 1)
+        bots = 1;
+
+#ifdef USE_GLFW
+    const char *backend = "GLFW";
+#if (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4) || GLFW_VERSION_MAJOR > 3
+    // Nothing here needs a real window system, unless a window was asked for
+    if (!withWindow)
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+#else
+    const char *backend = "SDL2";
+    // Keep any drivers that were explicitly asked for
+    if (!withWindow)
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+#endif
+
+    BzfPlatform *platform = PlatformFactory::create();
+
+    printf("Backend: %s, %s dispatch\n\n", backend, dispatch);
+    printf("%-20s %12s %14s\n", "benchmark", "operations", "ns/operation");
+
+    benchmarkKeys(iterations);
+    benchmarkEvents(platform, iterations);
+    benchmarkNullPlatforms(iterations, bots);
+    benchmarkAudio(platform, iterations);
+    benchmarkDispatch(platform, withWindow, iterations * 100);
+    benchmarkShaderBuild(shader, iterations / 1000 + 1);
+
+    if (!writeJSON(output, backend))
+        return EXIT_FAILURE;
+
+    delete platform;
+
+    return EXIT_SUCCESS;
+}
@@ -6,16 +6,11 @@
 #include "SDL2Platform.h"
 #endif
 
-BzfPlatform* PlatformFactory::get()
+BzfPlatform* PlatformFactory::create()
 {
-    static BzfPlatform* platform = nullptr;
-
-    if (platform == nullptr)
 #ifdef USE_GLFW
-        platform = new GLFWPlatform();
+    return new GLFWPlatform();
 #else
-        platform = new SDL2Platform();
+    return new SDL2Platform();
 #endif
-
-    return platform;
 }
@@ -5,5 +5,8 @@
 class PlatformFactory
 {
 public:
-    static BzfPlatform* get();
+    // A new platform of the backend that was built in, which belongs to the caller. Any number of them can exist at the
+    // same time, though SDL and GLFW windows still have to be handled on the main thread. Headless clients can use a
+    // NullPlatform instead, which can run on any thread.
+    static BzfPlatform* create();
 };
@@ -0,0 +1,107 @@
+#include "RenderScaleController.h"
+
+#include <math.h>
+
+// Weight of the latest frame in the moving average
+static const double averageWeight = 0.1;
+// Shrink once the average is this far over budget for a number of frames in a row
+static const double overBudgetRatio = 1.05;
+static const int framesBeforeShrink = 8;
+// Grow once the average is this far under budget for a (longer) number of frames in a row
+static const double underBudgetRatio = 0.8;
+static const int framesBeforeGrow = 30;
+// Largest change made in a single step
+static const float maxShrinkStep = 0.1f;
+static const float growStep = 0.05f;
+
+RenderScaleController::RenderScaleController(double _targetFrameTime, float _minScale, float _maxScale) :
+    targetFrameTime(_targetFrameTime), minScale(_minScale), maxScale(_maxScale), scale(_maxScale),
+    averageFrameTime(0.0), framesOverBudget(0), framesUnderBudget(0)
+{
+}
+
+void RenderScaleController::setTargetFrameTime(double seconds)
+{
+    if (seconds > 0.0)
+        targetFrameTime = seconds;
+}
+
+double RenderScaleController::getTargetFrameTime() const
+{
+    return targetFrameTime;
+}
+
+void RenderScaleController::setScaleRange(float _minScale, float _maxScale)
+{
+    if (_minScale <= 0.0f || _maxScale < _minScale)
+        return;
+    minScale = _minScale;
+    maxScale = _maxScale;
+    if (scale < minScale)
+        scale = minScale;
+    else if (scale > maxScale)
+        scale = maxScale;
+}
+
+float RenderScaleController::update(double frameTime)
+{
+    // Ignore bogus samples, such as the first frame or a stall while the window was being dragged
+    if (frameTime <= 0.0 || frameTime > 1.0)
+        return scale;
+
+    if (averageFrameTime <= 0.0)
+        averageFrameTime = frameTime;
+    else
+        averageFrameTime += (frameTime - averageFrameTime) * averageWeight;
+
+    if (averageFrameTime > targetFrameTime * overBudgetRatio)
+    {
+        framesUnderBudget = 0;
+        if (++framesOverBudget >= framesBeforeShrink && scale > minScale)
+        {
+            float wanted = scale * (float)sqrt(targetFrameTime / averageFrameTime);
+            if (wanted < scale - maxShrinkStep)
+                wanted = scale - maxShrinkStep;
+            scale = (wanted < minScale) ? minScale : wanted;
+            framesOverBudget = 0;
+            // The average still reflects the old resolution, so start it over
+            averageFrameTime = 0.0;
+        }
+    }
+    else if (averageFrameTime < targetFrameTime * underBudgetRatio)
+    {
+        framesOverBudget = 0;
+        if (++framesUnderBudget >= framesBeforeGrow && scale < maxScale)
+        {
+            scale = (scale + growStep > maxScale) ? maxScale : scale + growStep;
+            framesUnderBudget = 0;
+            averageFrameTime = 0.0;
+        }
+    }
+    else
+    {
+        // Within the hysteresis band, so leave the scale alone
+        framesOverBudget = 0;
+        framesUnderBudget = 0;
+    }
+
+    return scale;
+}
+
+float RenderScaleController::getScale() const
+{
+    return scale;
+}
+
+double RenderScaleController::getAverageFrameTime() const
+{
+    return averageFrameTime;
+}
+
+void RenderScaleController::reset()
+{
+    scale = maxScale;
+    averageFrameTime = 0.0;
+    framesOverBudget = 0;
+    framesUnderBudget = 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// Picks a render resolution scale that keeps the frame time within a budget. The cost of the fragment shaders we draw
+// is roughly proportional to the number of pixels, so the scale is adjusted by the square root of the time ratio.
+// Separate thresholds and frame counts for shrinking and growing keep the scale from oscillating.
+class RenderScaleController
+{
+public:
+    RenderScaleController(double targetFrameTime = 1.0 / 60.0, float minScale = 0.5f, float maxScale = 1.0f);
+
+    // Frame time budget, in seconds
+    void setTargetFrameTime(double seconds);
+    double getTargetFrameTime() const;
+    void setScaleRange(float minScale, float maxScale);
+
+    // Feed the duration of the last frame (in seconds) and get the scale to use for the next one
+    float update(double frameTime);
+    float getScale() const;
+    double getAverageFrameTime() const;
+
+    // Go back to full scale and forget any frame time history
+    void reset();
+
+private:
+    double targetFrameTime;
+    float minScale;
+    float maxScale;
+    float scale;
+
+    // Exponential moving average of the frame time
+    double averageFrameTime;
+    int framesOverBudget;
+    int framesUnderBudget;
+};
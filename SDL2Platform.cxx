@@ -1,6 +1,10 @@
 #include "SDL2Platform.h"
+#include "BzfMetrics.h"
+#include "BzfProfiler.h"
 #include <stdio.h>
 #include <iostream>
+#include <algorithm>
+#include <mutex>
 #include <vector>
 #ifdef _WIN32
 #  include <windows.h>
@@ -10,17 +14,43 @@
 // Platform
 ///////////////////////////////////////////////////////////
 
+// Tag input for a window with the time it arrived, for latency measurement. SDL stamps events with SDL_GetTicks() when
+// they are queued, so the time they spent waiting for pollEvents() is included (to the millisecond).
+static void markInput(SDL2Window* window, Uint32 timestamp)
+{
+    if (window == nullptr || !window->getLatencyTracker().isEnabled())
+        return;
+
+    uint64_t now = BzfClock::now();
+    Uint32 age = SDL_GetTicks() - timestamp;
+    // Anything older than a second is more likely a bogus timestamp than a real delay
+    if (age > 1000)
+        age = 0;
+    window->getLatencyTracker().inputArrived(now - age * (BzfClock::ticksPerSecond / 1000));
+}
+
+// The platforms of the process, which share SDL. It is set up with the first and shut down with the last of them.
+static std::mutex instancesMutex;
+static std::vector<SDL2Platform*> instances;
+
 SDL2Platform::SDL2Platform() : audio(nullptr), joystick(nullptr)
 {
-    SDL_SetMainReady();
-    if (SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS | SDL_INIT_VIDEO) != 0)
     {
-        std::cerr << "Error: There was an error initializing SDL2: " << SDL_GetError() << std::endl;
-        exit(-1);
-    }
+        std::lock_guard<std::mutex> lock(instancesMutex);
+        if (instances.empty())
+        {
+            SDL_SetMainReady();
+            if (SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS | SDL_INIT_VIDEO) != 0)
+            {
+                std::cerr << "Error: There was an error initializing SDL2: " << SDL_GetError() << std::endl;
+                exit(-1);
+            }
 
-    // SDL automatically starts text input when the video subsystem is initialized, so stop that
-    SDL_StopTextInput();
+            // SDL automatically starts text input when the video subsystem is initialized, so stop that
+            SDL_StopTextInput();
+        }
+        instances.push_back(this);
+    }
 
     // Set the depth and stencil buffer precision
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 16);
@@ -33,39 +63,60 @@ SDL2Platform::SDL2Platform() : audio(nullptr), joystick(nullptr)
     // Enable double buffering
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 
-#ifdef _DEBUG
-    // For debugging, set the start time of the program to be 184 days in the past to catch issues that may occur with long running programs
-    startTime = SDL_GetPerformanceCounter() - (SDL_GetPerformanceFrequency() * 60 * 60 * 24 * 184);
-#else
-    startTime = SDL_GetPerformanceCounter();
-#endif
+    // Nothing has a callback yet
+    callbacksChanged();
 }
 
 SDL2Platform::~SDL2Platform()
 {
+    shutdownJobSystem();
+
     // Delete all the windows (Is this necessary?)
     for (auto window : windows)
         if (window != nullptr)
             delete window;
+    BzfMetrics::get().gauge("windows")->add(-(double)windows.size());
 
-    // Shut down SDL2
-    SDL_Quit();
+    // Shut down SDL2 once no other platform uses it
+    std::lock_guard<std::mutex> lock(instancesMutex);
+    instances.erase(std::find(instances.begin(), instances.end(), this));
+    if (instances.empty())
+        SDL_Quit();
 }
 
 BzfWindow* SDL2Platform::createWindow(int width, int height, BzfMonitor* monitor, int positionX, int positionY)
 {
-    SDL2Window* window = new SDL2Window(width, height, static_cast<SDL2Monitor*>(monitor), positionX, positionY);
+    SDL2Window* shareWith = (GLGetSharedContexts() && !windows.empty()) ? windows.front() : nullptr;
+    SDL2Window* window = new SDL2Window(width, height, static_cast<SDL2Monitor*>(monitor), positionX, positionY,
+                                        shareWith);
     windows.push_back(window);
+    windowRegistry.add(window->getWindowID(), window);
+    BzfMetrics::get().gauge("windows")->add(1);
     return window;
 }
 
 BzfWindow* SDL2Platform::createWindow(BzfResolution resolution, BzfMonitor* monitor)
 {
-    SDL2Window* window = new SDL2Window(resolution, static_cast<SDL2Monitor*>(monitor));
+    SDL2Window* shareWith = (GLGetSharedContexts() && !windows.empty()) ? windows.front() : nullptr;
+    SDL2Window* window = new SDL2Window(resolution, static_cast<SDL2Monitor*>(monitor), shareWith);
     windows.push_back(window);
+    windowRegistry.add(window->getWindowID(), window);
+    BzfMetrics::get().gauge("windows")->add(1);
     return window;
 }
 
+void SDL2Platform::destroyWindow(BzfWindow* window)
+{
+    auto found = std::find(windows.begin(), windows.end(), window);
+    if (found == windows.end())
+        return;
+
+    windowRegistry.remove((*found)->getWindowID());
+    windows.erase(found);
+    delete window;
+    BzfMetrics::get().gauge("windows")->add(-1);
+}
+
 BzfAudio* SDL2Platform::getAudio()
 {
     if (audio == nullptr)
@@ -91,11 +142,6 @@ bool SDL2Platform::isGameRunning() const
     return true;
 }
 
-double SDL2Platform::getGameTime() const
-{
-    return (double)(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
-}
-
 BzfMonitor* SDL2Platform::getPrimaryMonitor() const
 {
     SDL2Monitor* monitor = new SDL2Monitor;
@@ -181,196 +227,366 @@ void SDL2Platform::GLSetRGBA(unsigned short red, unsigned short green, unsigned
     SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, alpha);
 }
 
+void SDL2Platform::GLSetContextFlags(int flags) const
+{
+    int sdlFlags = 0;
+    if (flags & BZF_GL_CONTEXT_DEBUG)
+        sdlFlags |= SDL_GL_CONTEXT_DEBUG_FLAG;
+    if (flags & BZF_GL_CONTEXT_ROBUST)
+        sdlFlags |= SDL_GL_CONTEXT_ROBUST_ACCESS_FLAG;
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, sdlFlags);
+
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+    // A debug context that does not report errors would be pointless
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_NO_ERROR, (flags & BZF_GL_CONTEXT_NO_ERROR) && !(flags & BZF_GL_CONTEXT_DEBUG));
+#endif
+}
+
 void SDL2Platform::pollEvents()
 {
-    SDL_Event event;
-    while (SDL_PollEvent(&event))
+    BZF_PROFILE_ZONE("SDL2Platform::pollEvents");
+    static BzfCounter *events = BzfMetrics::get().counter("events");
+
+    // Ask the window system for its events once, then take them off the SDL queue in batches. SDL_PollEvent() would
+    // pump again for every single event.
+    SDL_PumpEvents();
+    // Joystick state is normally refreshed by pumping, but SDL skips that once no joystick events are enabled
+    if (joystick != nullptr && SDL_JoystickEventState(SDL_QUERY) == SDL_IGNORE)
+        SDL_JoystickUpdate();
+
+    SDL_Event batch[eventBatchSize];
+    int count;
+    do
+    {
+        count = SDL_PeepEvents(batch, eventBatchSize, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
+        if (count > 0)
+            events->add(count);
+        for (int i = 0; i < count; ++i)
+            dispatchEvent(batch[i]);
+    }
+    while (count == eventBatchSize);
+}
+
+void SDL2Platform::callbacksChanged()
+{
+    // Not handled at all. Joystick axes are read through SDL2Joystick::getAxis(), as their events only flood the queue.
+    const Uint32 unhandled[] = { SDL_TEXTEDITING, SDL_KEYMAPCHANGED, SDL_JOYAXISMOTION, SDL_JOYBALLMOTION,
+                                 SDL_CONTROLLERAXISMOTION, SDL_CONTROLLERBUTTONDOWN, SDL_CONTROLLERBUTTONUP,
+                                 SDL_FINGERDOWN, SDL_FINGERUP, SDL_FINGERMOTION, SDL_DOLLARGESTURE, SDL_DOLLARRECORD,
+                                 SDL_MULTIGESTURE, SDL_CLIPBOARDUPDATE, SDL_DROPFILE, SDL_DROPTEXT, SDL_DROPBEGIN,
+                                 SDL_DROPCOMPLETE
+                               };
+    for (auto type : unhandled)
+        SDL_EventState(type, SDL_IGNORE);
+
+    // SDL keeps its keyboard, mouse and joystick state up to date for ignored events as well. The types are turned on
+    // or off for all platforms of the process at once, so they stay on while any of them has a callback.
+    bool key = false, text = false, cursorPos = false, mouseButton = false, scroll = false, joystickButton = false,
+         joystickHat = false;
+    {
+        std::lock_guard<std::mutex> lock(instancesMutex);
+        for (auto instance : instances)
+        {
+            key = key || instance->keyCallback != nullptr;
+            text = text || instance->textCallback != nullptr;
+            cursorPos = cursorPos || instance->cursorPosCallback != nullptr;
+            mouseButton = mouseButton || instance->mouseButtonCallback != nullptr;
+            scroll = scroll || instance->scrollCallback != nullptr;
+            joystickButton = joystickButton || instance->joystickButtonCallback != nullptr;
+            joystickHat = joystickHat || instance->joystickHatCallback != nullptr;
+        }
+    }
+    SDL_EventState(SDL_KEYDOWN, key ? SDL_ENABLE : SDL_IGNORE);
+    SDL_EventState(SDL_KEYUP, key ? SDL_ENABLE : SDL_IGNORE);
+    SDL_EventState(SDL_TEXTINPUT, text ? SDL_ENABLE : SDL_IGNORE);
+#ifdef _WIN32
+    SDL_EventState(SDL_MOUSEMOTION, cursorPos ? SDL_ENABLE : SDL_IGNORE);
+#else
+    // Mouse confinement to a box is done by hand from the motion events
+    (void)cursorPos;
+    SDL_EventState(SDL_MOUSEMOTION, SDL_ENABLE);
+#endif
+    SDL_EventState(SDL_MOUSEBUTTONDOWN, mouseButton ? SDL_ENABLE : SDL_IGNORE);
+    SDL_EventState(SDL_MOUSEBUTTONUP, mouseButton ? SDL_ENABLE : SDL_IGNORE);
+    SDL_EventState(SDL_MOUSEWHEEL, scroll ? SDL_ENABLE : SDL_IGNORE);
+    SDL_EventState(SDL_JOYBUTTONDOWN, joystickButton ? SDL_ENABLE : SDL_IGNORE);
+    SDL_EventState(SDL_JOYBUTTONUP, joystickButton ? SDL_ENABLE : SDL_IGNORE);
+    SDL_EventState(SDL_JOYHATMOTION, joystickHat ? SDL_ENABLE : SDL_IGNORE);
+}
+
+// The window that an event is for, or 0 for events that are not tied to a window
+static Uint32 eventWindowID(const SDL_Event &event)
+{
+    switch(event.type)
+    {
+    // *INDENT-OFF*
+    case SDL_WINDOWEVENT: return event.window.windowID;
+    case SDL_KEYDOWN: case SDL_KEYUP: return event.key.windowID;
+    case SDL_TEXTINPUT: return event.text.windowID;
+    case SDL_MOUSEMOTION: return event.motion.windowID;
+    case SDL_MOUSEBUTTONDOWN: case SDL_MOUSEBUTTONUP: return event.button.windowID;
+    case SDL_MOUSEWHEEL: return event.wheel.windowID;
+    default: return 0;
+    // *INDENT-ON*
+    }
+}
+
+SDL2Platform* SDL2Platform::findOwner(Uint32 windowID)
+{
+    std::lock_guard<std::mutex> lock(instancesMutex);
+    for (auto instance : instances)
+    {
+        if (instance->windowRegistry.get(windowID) != nullptr)
+            return instance;
+    }
+    return nullptr;
+}
+
+void SDL2Platform::dispatchEvent(SDL_Event &event)
+{
+    Uint32 windowID = eventWindowID(event);
+    if (windowID != 0 && windowRegistry.get(windowID) == nullptr)
+    {
+        SDL2Platform *owner = findOwner(windowID);
+        if (owner != nullptr && owner != this)
+            owner->dispatchEvent(event);
+        return;
+    }
+
+    if (event.type == SDL_QUIT)
+    {
+        for (auto window : windows)
+            window->requestClose();
+    }
+    else if (event.type == SDL_WINDOWEVENT)
     {
-        if (event.type == SDL_QUIT)
+        auto window = getWindowFromSDLID(event.window.windowID);
+        // Events can still arrive for a window that was just destroyed
+        if (window == nullptr)
+            return;
+
+        window->handleWindowEvent(event.window.event);
+        if (event.window.event == SDL_WINDOWEVENT_CLOSE)
+            window->requestClose();
+        // Unlike SDL_WINDOWEVENT_RESIZED, this is also sent for changes that were not made by the user
+        else if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
         {
-            for (auto window : windows)
-                window->requestClose();
+            BZF_PROFILE_ZONE("resizeCallback");
+            // The event has the size in screen coordinates, but the callbacks want the viewport size in pixels
+            int width, height;
+            window->getDrawableSize(width, height);
+            for (auto resizeCallback : resizeCallbacks)
+                resizeCallback(this, window, width, height);
         }
-        else if (event.type == SDL_WINDOWEVENT)
+        else if (event.window.event == SDL_WINDOWEVENT_MOVED)
         {
-            auto window = getWindowFromSDLID(event.wheel.windowID);
-            if (event.window.event == SDL_WINDOWEVENT_CLOSE)
-                window->requestClose();
-            else if (event.window.event == SDL_WINDOWEVENT_RESIZED)
-            {
-                for (auto resizeCallback : resizeCallbacks)
-                    resizeCallback(this, window, event.window.data1, event.window.data2);
-            }
-            else if (event.window.event == SDL_WINDOWEVENT_MOVED)
-            {
-                for (auto moveCallback : moveCallbacks)
-                    moveCallback(this, window, event.window.data1, event.window.data2);
-            }
+            BZF_PROFILE_ZONE("moveCallback");
+            for (auto moveCallback : moveCallbacks)
+                moveCallback(this, window, event.window.data1, event.window.data2);
         }
-        else if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
+    }
+    else if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
+    {
+        BZF_PROFILE_ZONE("keyCallback");
+        if (keyCallback != nullptr)
         {
-            if (keyCallback != nullptr)
-            {
-                BzfKey key = keyFromSDL(event.key.keysym.sym);
-                if (key == BZF_KEY_UNKNOWN)
-                    continue;
+            BzfKey key = keyFromSDL(event.key.keysym.sym);
+            if (key == BZF_KEY_UNKNOWN)
+                return;
 
-                BzfKeyAction action = (event.key.state == SDL_PRESSED)?BZF_KEY_PRESSED:BZF_KEY_RELEASED;
-                if (action == BZF_KEY_PRESSED && event.key.repeat != 0)
-                    action = BZF_KEY_REPEATED;
+            BzfKeyAction action = (event.key.state == SDL_PRESSED)?BZF_KEY_PRESSED:BZF_KEY_RELEASED;
+            if (action == BZF_KEY_PRESSED && event.key.repeat != 0)
+                action = BZF_KEY_REPEATED;
 
-                keyCallback(this, getWindowFromSDLID(event.key.windowID), key, action, modsFromSDL(event.key.keysym.mod));
-            }
+            auto window = getWindowFromSDLID(event.key.windowID);
+            markInput(window, event.key.timestamp);
+            keyCallback(this, window, key, action, modsFromSDL(event.key.keysym.mod));
         }
-        else if (event.type == SDL_JOYBUTTONDOWN || event.type == SDL_JOYBUTTONUP)
+    }
+    else if (event.type == SDL_JOYBUTTONDOWN || event.type == SDL_JOYBUTTONUP)
+    {
+        BZF_PROFILE_ZONE("joystickButtonCallback");
+        if (joystickButtonCallback != nullptr)
         {
-            if (joystickButtonCallback != nullptr)
+            BzfJoyButton button;
+            // SDL starts their numbering at 0
+            switch(event.jbutton.button)
             {
-                BzfJoyButton button;
-                // SDL starts their numbering at 0
-                switch(event.jbutton.button)
-                {
-                // *INDENT-OFF*
-                case 0: button = BZF_JOY_BUTTON_1; break;
-                case 1: button = BZF_JOY_BUTTON_2; break;
-                case 2: button = BZF_JOY_BUTTON_3; break;
-                case 3: button = BZF_JOY_BUTTON_4; break;
-                case 4: button = BZF_JOY_BUTTON_5; break;
-                case 5: button = BZF_JOY_BUTTON_6; break;
-                case 6: button = BZF_JOY_BUTTON_7; break;
-                case 7: button = BZF_JOY_BUTTON_8; break;
-                case 8: button = BZF_JOY_BUTTON_9; break;
-                case 9: button = BZF_JOY_BUTTON_10; break;
-                case 10: button = BZF_JOY_BUTTON_11; break;
-                case 11: button = BZF_JOY_BUTTON_12; break;
-                case 12: button = BZF_JOY_BUTTON_13; break;
-                case 13: button = BZF_JOY_BUTTON_14; break;
-                case 14: button = BZF_JOY_BUTTON_15; break;
-                case 15: button = BZF_JOY_BUTTON_16; break;
-                case 16: button = BZF_JOY_BUTTON_17; break;
-                case 17: button = BZF_JOY_BUTTON_18; break;
-                case 18: button = BZF_JOY_BUTTON_19; break;
-                case 19: button = BZF_JOY_BUTTON_20; break;
-                case 20: button = BZF_JOY_BUTTON_21; break;
-                case 21: button = BZF_JOY_BUTTON_22; break;
-                case 22: button = BZF_JOY_BUTTON_23; break;
-                case 23: button = BZF_JOY_BUTTON_24; break;
-                case 24: button = BZF_JOY_BUTTON_25; break;
-                case 25: button = BZF_JOY_BUTTON_26; break;
-                case 26: button = BZF_JOY_BUTTON_27; break;
-                case 27: button = BZF_JOY_BUTTON_28; break;
-                case 28: button = BZF_JOY_BUTTON_29; break;
-                case 29: button = BZF_JOY_BUTTON_30; break;
-                case 30: button = BZF_JOY_BUTTON_31; break;
-                case 31: button = BZF_JOY_BUTTON_32; break;
-                default: button = BZF_JOY_BUTTON_UNKNOWN; break;
-                // *INDENT-ON*
-                }
-                if (button == BZF_JOY_BUTTON_UNKNOWN)
-                    continue;
-
-                joystickButtonCallback(this, getWindowFromSDLID(event.key.windowID), button,
-                                       (event.jbutton.state == SDL_PRESSED)?BZF_BUTTON_PRESSED:BZF_BUTTON_RELEASED);
+            // *INDENT-OFF*
+            case 0: button = BZF_JOY_BUTTON_1; break;
+            case 1: button = BZF_JOY_BUTTON_2; break;
+            case 2: button = BZF_JOY_BUTTON_3; break;
+            case 3: button = BZF_JOY_BUTTON_4; break;
+            case 4: button = BZF_JOY_BUTTON_5; break;
+            case 5: button = BZF_JOY_BUTTON_6; break;
+            case 6: button = BZF_JOY_BUTTON_7; break;
+            case 7: button = BZF_JOY_BUTTON_8; break;
+            case 8: button = BZF_JOY_BUTTON_9; break;
+            case 9: button = BZF_JOY_BUTTON_10; break;
+            case 10: button = BZF_JOY_BUTTON_11; break;
+            case 11: button = BZF_JOY_BUTTON_12; break;
+            case 12: button = BZF_JOY_BUTTON_13; break;
+            case 13: button = BZF_JOY_BUTTON_14; break;
+            case 14: button = BZF_JOY_BUTTON_15; break;
+            case 15: button = BZF_JOY_BUTTON_16; break;
+            case 16: button = BZF_JOY_BUTTON_17; break;
+            case 17: button = BZF_JOY_BUTTON_18; break;
+            case 18: button = BZF_JOY_BUTTON_19; break;
+            case 19: button = BZF_JOY_BUTTON_20; break;
+            case 20: button = BZF_JOY_BUTTON_21; break;
+            case 21: button = BZF_JOY_BUTTON_22; break;
+            case 22: button = BZF_JOY_BUTTON_23; break;
+            case 23: button = BZF_JOY_BUTTON_24; break;
+            case 24: button = BZF_JOY_BUTTON_25; break;
+            case 25: button = BZF_JOY_BUTTON_26; break;
+            case 26: button = BZF_JOY_BUTTON_27; break;
+            case 27: button = BZF_JOY_BUTTON_28; break;
+            case 28: button = BZF_JOY_BUTTON_29; break;
+            case 29: button = BZF_JOY_BUTTON_30; break;
+            case 30: button = BZF_JOY_BUTTON_31; break;
+            case 31: button = BZF_JOY_BUTTON_32; break;
+            default: button = BZF_JOY_BUTTON_UNKNOWN; break;
+            // *INDENT-ON*
             }
+            if (button == BZF_JOY_BUTTON_UNKNOWN)
+                return;
+
+            joystickButtonCallback(this, getWindowFromSDLID(event.key.windowID), button,
+                                   (event.jbutton.state == SDL_PRESSED)?BZF_BUTTON_PRESSED:BZF_BUTTON_RELEASED);
         }
-        else if (event.type == SDL_JOYHATMOTION)
+    }
+    else if (event.type == SDL_JOYHATMOTION)
+    {
+        BZF_PROFILE_ZONE("joystickHatCallback");
+        if (joystickHatCallback != nullptr)
         {
-            if (joystickHatCallback != nullptr)
+            BzfJoyHat hat;
+            // SDL starts their numbering at 0
+            switch(event.jhat.hat)
             {
-                BzfJoyHat hat;
-                // SDL starts their numbering at 0
-                switch(event.jhat.hat)
-                {
-                // *INDENT-OFF*
-                case 0: hat = BZF_JOY_HAT_1; break;
-                case 1: hat = BZF_JOY_HAT_2; break;
-                case 2: hat = BZF_JOY_HAT_3; break;
-                case 3: hat = BZF_JOY_HAT_4; break;
-                case 4: hat = BZF_JOY_HAT_5; break;
-                case 5: hat = BZF_JOY_HAT_6; break;
-                case 6: hat = BZF_JOY_HAT_7; break;
-                case 7: hat = BZF_JOY_HAT_8; break;
-                default: hat = BZF_JOY_HAT_UNKNOWN; break;
-                // *INDENT-ON*
-                }
-                if (hat == BZF_JOY_HAT_UNKNOWN)
-                    continue;
-
-                BzfJoyHatDirection direction;
-                switch(event.jhat.value)
-                {
-                // *INDENT-OFF*
-                case SDL_HAT_LEFTUP: direction = BZF_JOY_HAT_LEFTUP; break;
-                case SDL_HAT_UP: direction = BZF_JOY_HAT_UP; break;
-                case SDL_HAT_RIGHTUP: direction = BZF_JOY_HAT_RIGHTUP; break;
-                case SDL_HAT_LEFT: direction = BZF_JOY_HAT_LEFT; break;
-                case SDL_HAT_RIGHT: direction = BZF_JOY_HAT_RIGHT; break;
-                case SDL_HAT_LEFTDOWN: direction = BZF_JOY_HAT_LEFTDOWN; break;
-                case SDL_HAT_DOWN: direction = BZF_JOY_HAT_DOWN; break;
-                case SDL_HAT_RIGHTDOWN: direction = BZF_JOY_HAT_RIGHTDOWN; break;
-                default: direction = BZF_JOY_HAT_CENTERED; break;
-                // *INDENT-ON*
-                }
-                joystickHatCallback(this, getWindowFromSDLID(event.key.windowID), hat, direction);
+            // *INDENT-OFF*
+            case 0: hat = BZF_JOY_HAT_1; break;
+            case 1: hat = BZF_JOY_HAT_2; break;
+            case 2: hat = BZF_JOY_HAT_3; break;
+            case 3: hat = BZF_JOY_HAT_4; break;
+            case 4: hat = BZF_JOY_HAT_5; break;
+            case 5: hat = BZF_JOY_HAT_6; break;
+            case 6: hat = BZF_JOY_HAT_7; break;
+            case 7: hat = BZF_JOY_HAT_8; break;
+            default: hat = BZF_JOY_HAT_UNKNOWN; break;
+            // *INDENT-ON*
             }
-        }
-        else if (event.type == SDL_TEXTINPUT)
-        {
-            if (SDL_strlen(event.text.text) == 0 || event.text.text[0] == '\n')
+            if (hat == BZF_JOY_HAT_UNKNOWN)
                 return;
 
-            if (textCallback != nullptr)
-                textCallback(this, getWindowFromSDLID(event.text.windowID), event.text.text);
+            BzfJoyHatDirection direction;
+            switch(event.jhat.value)
+            {
+            // *INDENT-OFF*
+            case SDL_HAT_LEFTUP: direction = BZF_JOY_HAT_LEFTUP; break;
+            case SDL_HAT_UP: direction = BZF_JOY_HAT_UP; break;
+            case SDL_HAT_RIGHTUP: direction = BZF_JOY_HAT_RIGHTUP; break;
+            case SDL_HAT_LEFT: direction = BZF_JOY_HAT_LEFT; break;
+            case SDL_HAT_RIGHT: direction = BZF_JOY_HAT_RIGHT; break;
+            case SDL_HAT_LEFTDOWN: direction = BZF_JOY_HAT_LEFTDOWN; break;
+            case SDL_HAT_DOWN: direction = BZF_JOY_HAT_DOWN; break;
+            case SDL_HAT_RIGHTDOWN: direction = BZF_JOY_HAT_RIGHTDOWN; break;
+            default: direction = BZF_JOY_HAT_CENTERED; break;
+            // *INDENT-ON*
+            }
+            joystickHatCallback(this, getWindowFromSDLID(event.key.windowID), hat, direction);
         }
-        else if (event.type == SDL_MOUSEMOTION)
+    }
+    else if (event.type == SDL_TEXTINPUT)
+    {
+        BZF_PROFILE_ZONE("textCallback");
+        if (SDL_strlen(event.text.text) == 0 || event.text.text[0] == '\n')
+            return;
+
+        if (textCallback != nullptr)
         {
-            auto window = getWindowFromSDLID(event.motion.windowID);
+            auto window = getWindowFromSDLID(event.text.windowID);
+            markInput(window, event.text.timestamp);
+            textCallback(this, window, event.text.text);
+        }
+    }
+    else if (event.type == SDL_MOUSEMOTION)
+    {
+        BZF_PROFILE_ZONE("cursorPosCallback");
+        auto window = getWindowFromSDLID(event.motion.windowID);
 
 #ifndef _WIN32
-            // For non-Windows platforms, we need to manually confine to the motion box
-            if (window->getConfineMouse() == BZF_MOUSE_CONFINED_BOX)
-                window->checkMouseConfineBox(event.motion.x, event.motion.y);
+        // For non-Windows platforms, we need to manually confine to the motion box
+        if (window != nullptr && window->getConfineMouse() == BZF_MOUSE_CONFINED_BOX)
+            window->checkMouseConfineBox(event.motion.x, event.motion.y);
 #endif
 
-            if (cursorPosCallback != nullptr)
-                cursorPosCallback(this, window, event.motion.x, event.motion.y);
+        if (cursorPosCallback != nullptr)
+        {
+            markInput(window, event.motion.timestamp);
+            cursorPosCallback(this, window, event.motion.x, event.motion.y);
         }
-        else if (event.type == SDL_MOUSEBUTTONDOWN || event.type == SDL_MOUSEBUTTONUP)
+    }
+    else if (event.type == SDL_MOUSEBUTTONDOWN || event.type == SDL_MOUSEBUTTONUP)
+    {
+        BZF_PROFILE_ZONE("mouseButtonCallback");
+        if (mouseButtonCallback != nullptr)
         {
-            if (mouseButtonCallback != nullptr)
+            BzfMouseButton button;
+            // Unlike joystick buttons/hats, however, SDL starts their mouse button numbering at 1...
+            switch(event.button.button)
             {
-                BzfMouseButton button;
-                // Unlike joystick buttons/hats, however, SDL starts their mouse button numbering at 1...
-                switch(event.button.button)
-                {
-                // *INDENT-OFF*
-                case 1: button = BZF_MOUSE_LEFT; break;
-                case 2: button = BZF_MOUSE_MIDDLE; break;
-                case 3: button = BZF_MOUSE_RIGHT; break;
-                case 4: button = BZF_MOUSE_4; break;
-                case 5: button = BZF_MOUSE_5; break;
-                case 6: button = BZF_MOUSE_6; break;
-                case 7: button = BZF_MOUSE_7; break;
-                case 8: button = BZF_MOUSE_8; break;
-                default: button = BZF_MOUSE_UNKNOWN; break;
-                // *INDENT-ON*
-                }
-                if (button == BZF_MOUSE_UNKNOWN)
-                    continue;
-
-                mouseButtonCallback(this, getWindowFromSDLID(event.button.windowID), button,
-                                    (event.button.state == SDL_PRESSED)?BZF_BUTTON_PRESSED:BZF_BUTTON_RELEASED, modsFromSDL(SDL_GetModState()));
+            // *INDENT-OFF*
+            case 1: button = BZF_MOUSE_LEFT; break;
+            case 2: button = BZF_MOUSE_MIDDLE; break;
+            case 3: button = BZF_MOUSE_RIGHT; break;
+            case 4: button = BZF_MOUSE_4; break;
+            case 5: button = BZF_MOUSE_5; break;
+            case 6: button = BZF_MOUSE_6; break;
+            case 7: button = BZF_MOUSE_7; break;
+            case 8: button = BZF_MOUSE_8; break;
+            default: button = BZF_MOUSE_UNKNOWN; break;
+            // *INDENT-ON*
             }
+            if (button == BZF_MOUSE_UNKNOWN)
+                return;
+
+            auto window = getWindowFromSDLID(event.button.windowID);
+            markInput(window, event.button.timestamp);
+            mouseButtonCallback(this, window, button,
+                                (event.button.state == SDL_PRESSED)?BZF_BUTTON_PRESSED:BZF_BUTTON_RELEASED, modsFromSDL(SDL_GetModState()));
         }
-        else if (event.type == SDL_MOUSEWHEEL)
+    }
+    else if (event.type == SDL_MOUSEWHEEL)
+    {
+        BZF_PROFILE_ZONE("scrollCallback");
+        if (scrollCallback != nullptr)
         {
-            if (scrollCallback != nullptr)
-                // TODO: Take direction into account and reverse the values?
-                scrollCallback(this, getWindowFromSDLID(event.wheel.windowID), event.wheel.x, event.wheel.y);
+            auto window = getWindowFromSDLID(event.wheel.windowID);
+            markInput(window, event.wheel.timestamp);
+            // TODO: Take direction into account and reverse the values?
+            scrollCallback(this, window, event.wheel.x, event.wheel.y);
         }
     }
 }
 
+void SDL2Platform::waitEvents(double timeout)
+{
+    BZF_PROFILE_ZONE("SDL2Platform::waitEvents");
+    // Without an event to fill in, this leaves the event in the queue for pollEvents() to handle
+    SDL_WaitEventTimeout(nullptr, (int)(timeout * 1000.0));
+    pollEvents();
+}
+
+bool SDL2Platform::hasVisibleWindow() const
+{
+    for (auto window : windows)
+        if (!window->isHidden())
+            return true;
+
+    return false;
+}
+
 void SDL2Platform::startTextInput()
 {
     SDL_StartTextInput();
@@ -528,17 +744,18 @@ int SDL2Platform::modsFromSDL(int sdlMods)
 
 SDL2Window* SDL2Platform::getWindowFromSDLID(Uint32 id)
 {
-    SDL_Window* win = SDL_GetWindowFromID(id);
-    if (win == nullptr)
-        return nullptr;
-    return static_cast<SDL2Window*>(SDL_GetWindowData(win, "SDL2Window"));
+    return static_cast<SDL2Window*>(windowRegistry.get(id));
 }
 
 ///////////////////////////////////////////////////////////
 // Window
 ///////////////////////////////////////////////////////////
 
-SDL2Window::SDL2Window(int width, int height, SDL2Monitor* _monitor, int x, int y) : BzfWindow(), closeRequested(false),
+// The contextId of the window whose context is current on this thread, so that redundant switches can be skipped
+static thread_local uint64_t currentContext = 0;
+
+SDL2Window::SDL2Window(int width, int height, SDL2Monitor* _monitor, int x, int y, SDL2Window* shareWith) : BzfWindow(),
+    closeRequested(false),
     hasGamma(true), mouseConfinementMode(BZF_MOUSE_CONFINED_NONE)
 {
     mouseBox[0][0] = 0;
@@ -575,14 +792,13 @@ SDL2Window::SDL2Window(int width, int height, SDL2Monitor* _monitor, int x, int
         exit(-1);
     }
 
-    // Store a pointer to this SDL2Window inside the SDL window
-    SDL_SetWindowData(window, "SDL2Window", this);
-
-    glcontext = SDL_GL_CreateContext(window);
+    createContext(shareWith);
+    refreshState();
 }
 
 // TODO: Handle refresh rate - Might have to start windowed and then set the display mode using SDL_SetWindowDisplayMode, and finally switching to fullscreen
-SDL2Window::SDL2Window(BzfResolution resolution, SDL2Monitor* _monitor) : BzfWindow(), closeRequested(false),
+SDL2Window::SDL2Window(BzfResolution resolution, SDL2Monitor* _monitor, SDL2Window* shareWith) : BzfWindow(),
+    closeRequested(false),
     hasGamma(true), mouseConfinementMode(BZF_MOUSE_CONFINED_NONE)
 {
     mouseBox[0][0] = 0;
@@ -630,15 +846,52 @@ SDL2Window::SDL2Window(BzfResolution resolution, SDL2Monitor* _monitor) : BzfWin
         exit(-1);
     }
 
-    // Store a pointer to this SDL2Window inside the SDL window
-    SDL_SetWindowData(window, "SDL2Window", this);
+    createContext(shareWith);
+    refreshState();
+}
 
+void SDL2Window::createContext(SDL2Window* shareWith)
+{
+    // SDL shares with whichever context is current when the new one is created
+    if (shareWith != nullptr)
+    {
+        shareWith->makeContextCurrent();
+        SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    }
+
+    // Creating the context also makes it current
     glcontext = SDL_GL_CreateContext(window);
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+    // Not every driver that SDL asks for a context without error checking can make one
+    int noError = 0;
+    if (glcontext == nullptr && SDL_GL_GetAttribute(SDL_GL_CONTEXT_NO_ERROR, &noError) == 0 && noError != 0)
+    {
+        std::cerr << "Unable to create a context without error checking: " << SDL_GetError() << std::endl;
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_NO_ERROR, 0);
+        glcontext = SDL_GL_CreateContext(window);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_NO_ERROR, 1);
+    }
+#endif
+    if (glcontext != nullptr)
+        currentContext = contextId;
+    else if (shareWith != nullptr)
+        std::cerr << "Unable to create a shared context: " << SDL_GetError() << std::endl;
+
+    if (shareWith != nullptr)
+        SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+
+    if (glcontext != nullptr && !loadGLFunctions(SDL_GL_GetProcAddress, glCapabilities))
+    {
+        std::cerr << "Unable to load the OpenGL functions" << std::endl;
+        exit(-1);
+    }
 }
 
 SDL2Window::~SDL2Window()
 {
-    // Delete the OpenGL context
+    // Delete the OpenGL context, which also releases it if it is current
+    if (currentContext == contextId)
+        currentContext = 0;
     SDL_GL_DeleteContext(glcontext);
 
     // Destroy the SDL window
@@ -647,31 +900,24 @@ SDL2Window::~SDL2Window()
 
 
 
-bool SDL2Window::isFullscreen() const
+BzfSwapPolicy SDL2Window::setSwapPolicy(BzfSwapPolicy policy) const
 {
-    return SDL_GetWindowFlags(window) & (SDL_WINDOW_FULLSCREEN | SDL_WINDOW_FULLSCREEN_DESKTOP);
-}
-
-bool SDL2Window::setVerticalSync(bool sync) const
-{
-    if (sync)
+    if (SDL_GL_SetSwapInterval(swapIntervalFor(policy)) != 0)
     {
-        // Try to set adaptive vsync
-        if (SDL_GL_SetSwapInterval(-1) == -1)
-            // Try to set normal vsync
-            if (SDL_GL_SetSwapInterval(1) == -1)
-                return false;
+        printf("Could not set swap policy %d: %s\n", policy, SDL_GetError());
+        // Adaptive and half rate sync are extensions, but plain vertical sync is widely available
+        if (policy == BZF_SWAP_ADAPTIVE || policy == BZF_SWAP_HALF_RATE)
+            SDL_GL_SetSwapInterval(1);
     }
-    else
-        SDL_GL_SetSwapInterval(0);
-    return true;
-}
 
-bool SDL2Window::getWindowSize(int &width, int &height) const
-{
-    // TODO: Check if this is the right function for both fullscreen and windowed
-    SDL_GetWindowSize(window, &width, &height);
-    return true;
+    // Ask for the interval rather than trusting the return values, since some drivers accept intervals they ignore
+    swapPolicy = swapPolicyFor(SDL_GL_GetSwapInterval());
+
+    SDL_DisplayMode mode;
+    if (SDL_GetWindowDisplayMode(window, &mode) == 0 && mode.refresh_rate > 0)
+        refreshInterval = 1.0 / mode.refresh_rate;
+
+    return swapPolicy;
 }
 
 bool SDL2Window::setWindowed(int width, int height, BzfMonitor* _monitor, int positionX, int positionY)
@@ -703,6 +949,7 @@ bool SDL2Window::setWindowed(int width, int height, BzfMonitor* _monitor, int po
     SDL_SetWindowFullscreen(window, 0);
     SDL_SetWindowSize(window, width, height);
     SDL_SetWindowPosition(window, positionX, positionY);
+    refreshState();
 
     return true;
 }
@@ -750,6 +997,7 @@ bool SDL2Window::setFullscreen(BzfResolution resolution, BzfMonitor* _monitor)
     }
 
     // TODO: Handle multiple monitors as I imagine this will use only the primary display
+    refreshState();
 
     return true;
 }
@@ -880,12 +1128,32 @@ void SDL2Window::checkMouseConfineBox(int mouseX, int mouseY)
 
 void SDL2Window::makeContextCurrent() const
 {
-    SDL_GL_MakeCurrent(window, glcontext);
+    if (currentContext == contextId)
+        return;
+
+    if (SDL_GL_MakeCurrent(window, glcontext) == 0)
+    {
+        currentContext = contextId;
+        ++contextSwitches;
+    }
+    else
+        currentContext = 0;
+}
+
+void SDL2Window::releaseContext() const
+{
+    if (currentContext != contextId)
+        return;
+
+    SDL_GL_MakeCurrent(window, nullptr);
+    currentContext = 0;
 }
 
 void SDL2Window::swapBuffers() const
 {
+    BZF_PROFILE_ZONE("SDL2Window::swapBuffers");
     SDL_GL_SwapWindow(window);
+    recordSwap();
 
     // TODO: Include our workaround for an SDL2 vsync bug on macOS
 }
@@ -914,6 +1182,53 @@ void SDL2Window::requestClose()
     closeRequested = true;
 }
 
+void SDL2Window::handleWindowEvent(Uint8 event)
+{
+    // Only ask SDL again for the events that can change the state
+    switch(event)
+    {
+    // *INDENT-OFF*
+    case SDL_WINDOWEVENT_SHOWN:
+    case SDL_WINDOWEVENT_HIDDEN:
+    case SDL_WINDOWEVENT_EXPOSED:
+    case SDL_WINDOWEVENT_MOVED:
+    case SDL_WINDOWEVENT_SIZE_CHANGED:
+    case SDL_WINDOWEVENT_MINIMIZED:
+    case SDL_WINDOWEVENT_MAXIMIZED:
+    case SDL_WINDOWEVENT_RESTORED:
+    case SDL_WINDOWEVENT_FOCUS_GAINED:
+    case SDL_WINDOWEVENT_FOCUS_LOST: refreshState(); break;
+    default: break;
+    // *INDENT-ON*
+    }
+}
+
+void SDL2Window::refreshState()
+{
+    BzfWindowState newState;
+    SDL_GetWindowSize(window, &newState.width, &newState.height);
+    // This is larger than the window size on HiDPI displays
+    SDL_GL_GetDrawableSize(window, &newState.drawableWidth, &newState.drawableHeight);
+    SDL_GetWindowPosition(window, &newState.x, &newState.y);
+
+    Uint32 flags = SDL_GetWindowFlags(window);
+    newState.fullscreen = (flags & (SDL_WINDOW_FULLSCREEN | SDL_WINDOW_FULLSCREEN_DESKTOP)) != 0;
+    newState.focused = (flags & SDL_WINDOW_INPUT_FOCUS) != 0;
+    newState.minimized = (flags & SDL_WINDOW_MINIMIZED) != 0;
+    newState.hidden = (flags & SDL_WINDOW_HIDDEN) != 0;
+
+    newState.displayIndex = SDL_GetWindowDisplayIndex(window);
+    if (newState.displayIndex < 0)
+        newState.displayIndex = 0;
+
+    setState(newState);
+}
+
+Uint32 SDL2Window::getWindowID() const
+{
+    return SDL_GetWindowID(window);
+}
+
 bool SDL2Window::shouldClose() const
 {
     return closeRequested;
@@ -923,15 +1238,15 @@ bool SDL2Window::shouldClose() const
 // Audio
 ///////////////////////////////////////////////////////////
 
-SDL2Audio::SDL2Audio() : dev(0)
+SDL2Audio::SDL2Audio() : dev(0), audioReady(false), audioOutputRate(defaultAudioRate), outputBufferEmpty(true), cmdFill(0),
+    userCallback(nullptr), sampleToSend(0), callbackCounter(BzfMetrics::get().counter("audio.callbacks")),
+    underrunCounter(BzfMetrics::get().counter("audio.underruns")), profileBuffer(nullptr)
 {
-    if (!(SDL_WasInit(SDL_INIT_AUDIO) != 0))
+    // SDL counts the initializations of each subsystem, so that every platform's audio can quit its own
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0)
     {
-        if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0)
-        {
-            std::cerr << "Error: There was an error initializing SDL2 audio: " << SDL_GetError() << std::endl;
-            exit(-1);
-        }
+        std::cerr << "Error: There was an error initializing SDL2 audio: " << SDL_GetError() << std::endl;
+        exit(-1);
     }
 }
 
@@ -963,6 +1278,11 @@ bool SDL2Audio::openDevice(const char *name)
     desired.callback = &fillAudioWrapper;
     desired.userdata = (void*)this;
 
+#ifdef BZF_PROFILING
+    // For the callback thread, which must not allocate one itself. Kept for the devices opened after this one.
+    if (profileBuffer == nullptr)
+        profileBuffer = BzfProfiler::reserveBuffer();
+#endif
     dev = SDL_OpenAudioDevice(name, 0, &desired, &obtained, 0);
 
     if (dev == 0)
@@ -1016,14 +1336,14 @@ void            SDL2Audio::startAudioCallback(bool (*proc)(void))
 {
     userCallback = proc;
     // Stop sending silence and start calling audio callback
-    SDL_PauseAudio(0);
+    SDL_PauseAudioDevice(dev, 0);
 }
 
 void            SDL2Audio::writeSoundCommand(const void* cmd, int len)
 {
     if (!audioReady) return;
 
-    SDL_LockAudio();
+    SDL_LockAudioDevice(dev);
 
     // Discard command if full
     if ((cmdFill + len) < 2048)
@@ -1034,7 +1354,7 @@ void            SDL2Audio::writeSoundCommand(const void* cmd, int len)
         cmdFill += len;
     }
 
-    SDL_UnlockAudio();
+    SDL_UnlockAudioDevice(dev);
 }
 
 bool            SDL2Audio::readSoundCommand(void* cmd, int len)
@@ -1064,7 +1384,12 @@ int         SDL2Audio::getAudioBufferChunkSize() const
 
 void SDL2Audio::fillAudio (Uint8 * stream, int len)
 {
-    static int sampleToSend;  // next sample to send on output buffer
+#ifdef BZF_PROFILING
+    BzfProfiler::adoptBuffer(profileBuffer);
+#endif
+    BZF_PROFILE_THREAD("audio");
+    BZF_PROFILE_ZONE("SDL2Audio::fillAudio");
+    callbackCounter->add();
     if (outputBufferEmpty)
     {
         userCallback();
@@ -1078,7 +1403,12 @@ void SDL2Audio::fillAudio (Uint8 * stream, int len)
         outputBufferEmpty = false;
     }
     else
+    {
         outputBufferEmpty = true;
+        // The rest of the stream is left without fresh samples
+        if (transferSize < len)
+            underrunCounter->add();
+    }
 
     // just copying into the soundBuffer is enough, SDL is looking for
     // something different from silence sample
@@ -1160,20 +1490,16 @@ float*      SDL2Audio::doReadSound(const std::string &filename, int &numFrames,
 
 SDL2Joystick::SDL2Joystick() : device(nullptr), haptic(nullptr), rumbleSupported(false)
 {
-    if (!(SDL_WasInit(SDL_INIT_GAMECONTROLLER) != 0))
+    // Paired with the SDL_QuitSubSystem() of the destructor, which SDL counts, so that joysticks of several platforms
+    // can come and go independently
+    if (SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER) != 0)
     {
-        if (SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER) != 0)
-        {
-            std::cerr << "Error: There was an error initializing SDL2 game controller support: " << SDL_GetError() << std::endl;
-            exit(-1);
-        }
+        std::cerr << "Error: There was an error initializing SDL2 game controller support: " << SDL_GetError() << std::endl;
+        exit(-1);
     }
 
-    if (!(SDL_WasInit(SDL_INIT_HAPTIC) != 0))
-    {
-        if (SDL_InitSubSystem(SDL_INIT_HAPTIC) != 0)
-            std::cerr << "Error: There was an error initializing SDL2 haptic support: " << SDL_GetError() << std::endl;
-    }
+    if (SDL_InitSubSystem(SDL_INIT_HAPTIC) != 0)
+        std::cerr << "Error: There was an error initializing SDL2 haptic support: " << SDL_GetError() << std::endl;
 }
 
 SDL2Joystick::~SDL2Joystick()
@@ -1,10 +1,11 @@
 #pragma once
 
 #include "BzfPlatform.h"
+#include "BzfWindowRegistry.h"
 
 #define SDL_MAIN_HANDLED
 
-#include <GL/glew.h>
+#include "BzfGL.h"
 #include <SDL2/SDL.h>
 
 #include <vector>
@@ -17,8 +18,9 @@ struct SDL2Monitor : public BzfMonitor
 class SDL2Window;
 class SDL2Audio;
 class SDL2Joystick;
+struct BzfProfileBuffer;
 
-class SDL2Platform : public BzfPlatform
+class SDL2Platform final : public BzfPlatform
 {
 public:
     SDL2Platform();
@@ -26,6 +28,7 @@ public:
 
     BzfWindow* createWindow(int width, int height, BzfMonitor* monitor = nullptr, int positionX = -1, int positionY = -1);
     BzfWindow* createWindow(BzfResolution resolution, BzfMonitor* monitor = nullptr);
+    void destroyWindow(BzfWindow* window);
 
     // Audio
     BzfAudio* getAudio();
@@ -35,9 +38,6 @@ public:
 
     bool isGameRunning() const;
 
-    // Timers
-    double getGameTime() const;
-
     // Monitors
     BzfMonitor* getPrimaryMonitor() const;
     std::vector<BzfMonitor*> getMonitors() const;
@@ -49,37 +49,54 @@ public:
     void GLSetVersion(BzfGLProfile profile, unsigned short majorVersion, unsigned short minorVersion) const;
     // Set minumum color depth
     void GLSetRGBA(unsigned short red, unsigned short green, unsigned short blue, unsigned short alpha) const;
+    void GLSetContextFlags(int flags) const;
 
     // Events
     // This will poll for events and call any set callbacks
     void pollEvents();
+    void waitEvents(double timeout);
+
+    bool hasVisibleWindow() const;
 
     void startTextInput();
     void stopTextInput();
     bool isTextInput();
 
+    // Input translation
+    static BzfKey keyFromSDL(SDL_Keycode key);
+    static int modsFromSDL(int sdlMods);
+
+protected:
+    // Enable only the event types that are handled and have a callback
+    void callbacksChanged();
+
 private:
+    // Events taken off the SDL queue at once by pollEvents()
+    static const int eventBatchSize = 64;
+
     std::vector<SDL2Window*> windows;
+    // Routes events by their SDL window ID
+    BzfWindowRegistry windowRegistry;
     SDL2Audio *audio;
     SDL2Joystick *joystick;
-    Uint64 startTime;
 
-    BzfKey keyFromSDL(SDL_Keycode key);
-    int modsFromSDL(int sdlMods);
     SDL2Window* getWindowFromSDLID(Uint32 id);
+    void dispatchEvent(SDL_Event &event);
+    // SDL has one event queue for the whole process. With several platforms, whichever polls it passes the events of
+    // windows it does not own on to the platform that does.
+    static SDL2Platform* findOwner(Uint32 windowID);
 };
 
-class SDL2Window : public BzfWindow
+class SDL2Window final : public BzfWindow
 {
 public:
-    SDL2Window(int width, int height, SDL2Monitor* monitor = nullptr, int positionX = -1, int positionY = -1);
-    SDL2Window(BzfResolution resolution, SDL2Monitor* monitor = nullptr);
+    // With shareWith, the context shares its objects with that window's context
+    SDL2Window(int width, int height, SDL2Monitor* monitor = nullptr, int positionX = -1, int positionY = -1,
+               SDL2Window* shareWith = nullptr);
+    SDL2Window(BzfResolution resolution, SDL2Monitor* monitor = nullptr, SDL2Window* shareWith = nullptr);
     ~SDL2Window();
 
     // Fullscreen/Windowed
-    bool isFullscreen() const;
-    bool setVerticalSync(bool sync) const;
-    bool getWindowSize(int &width, int &height) const;
     bool setWindowed(int width, int height, BzfMonitor* monitor = nullptr, int x = -1, int y = -1);
     bool setFullscreen(BzfResolution resolution, BzfMonitor* monitor = nullptr);
     void iconify() const;
@@ -97,8 +114,12 @@ public:
     void checkMouseConfineBox(int mouseX, int mouseY);
 #endif
 
+    // Swap policy
+    BzfSwapPolicy setSwapPolicy(BzfSwapPolicy policy) const;
+
     // Drawing/context
     void makeContextCurrent() const;
+    void releaseContext() const;
     void swapBuffers() const;
 
     // Gamma control
@@ -109,6 +130,10 @@ public:
     // SDL2 window specific methods
     void requestClose();
     bool shouldClose() const;
+    // Keep the window state up to date
+    void handleWindowEvent(Uint8 event);
+    void refreshState();
+    Uint32 getWindowID() const;
 
 private:
     SDL_Window* window;
@@ -118,9 +143,11 @@ private:
 
     BzfMouseConfinement mouseConfinementMode;
     int mouseBox[2][2];
+
+    void createContext(SDL2Window* shareWith);
 };
 
-class SDL2Audio : public BzfAudio
+class SDL2Audio final : public BzfAudio
 {
 public:
     SDL2Audio();
@@ -155,9 +182,15 @@ private:
 
     bool (*userCallback)(void);
     SDL_AudioCVT convert;
+    int sampleToSend;  // next sample to send on output buffer
+
+    // Looked up ahead of time, as the callback runs on a real-time thread that must not allocate or lock
+    BzfCounter *callbackCounter;
+    BzfCounter *underrunCounter;
+    BzfProfileBuffer *profileBuffer;
 };
 
-class SDL2Joystick : public BzfJoystick
+class SDL2Joystick final : public BzfJoystick
 {
 public:
     SDL2Joystick();
@@ -0,0 +1,146 @@
+// Headless frame throughput benchmark for GLHelloWorld
+//
+// Renders every shader in shaders/ into an offscreen framebuffer for a number of frames at a few fixed resolutions
+// and reports the frame rate, frame time percentiles and a checksum of the final image. A surfaceless EGL context is
+// used, so this runs on machines without a display or GPU (for instance with Mesa's llvmpipe driver, which can be
+// forced with LIBGL_ALWAYS_SOFTWARE=1).
+//
+// Usage: shaderBenchmark [-frames N] [-resolution WxH]... [-shader name.frag]...
+
+#include "GLHelloWorld.h"
+#include "HeadlessContext.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+
+struct BenchmarkResolution
+{
+    int width;
+    int height;
+};
+
+static std::vector<std::string> findShaders()
+{
+    std::vector<std::string> shaders;
+    const char* paths[] = { "shaders", "../shaders", "../../shaders" };
+
+    for (auto path : paths)
+    {
+        DIR* dir = opendir(path);
+        if (dir == nullptr)
+            continue;
+
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr)
+        {
+            std::string name = entry->d_name;
+            if (name.size() > 5 && name.compare(name.size() - 5, 5, ".frag") == 0)
+                shaders.push_back(name);
+        }
+        closedir(dir);
+        break;
+    }
+
+    std::sort(shaders.begin(), shaders.end());
+    return shaders;
+}
+
+static double percentile(const std::vector<double> &sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+int main(int argc, char** argv)
+{
+    int frames = 100;
+    std::vector<BenchmarkResolution> resolutions;
+    std::vector<std::string> shaders;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+            frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-resolution") == 0 && i + 1 < argc)
+        {
+            BenchmarkResolution resolution;
+            if (sscanf(argv[++i], "%dx%d", &resolution.width, &resolution.height) == 2 && resolution.width > 0
+                    && resolution.height > 0)
+                resolutions.push_back(resolution);
+        }
+        else if (strcmp(argv[i], "-shader") == 0 && i + 1 < argc)
+            shaders.push_back(argv[++i]);
+        else
+        {
+            printf("Usage: %s [-frames N] [-resolution WxH]... [-shader name.frag]...\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (frames < 1)
+        frames = 1;
+    if (resolutions.empty())
+        resolutions = { {320, 240}, {640, 480}, {1280, 720} };
+    if (shaders.empty())
+        shaders = findShaders();
+    if (shaders.empty())
+    {
+        fprintf(stderr, "Error: No shaders found\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!createHeadlessContext())
+        return EXIT_FAILURE;
+
+    printf("Renderer: %s (%s)\n\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+    printf("%-16s %11s %7s %9s %9s %9s %9s %9s  %s\n", "shader", "resolution", "frames", "fps", "p50 ms", "p90 ms",
+           "p99 ms", "max ms", "checksum");
+
+    for (auto &shader : shaders)
+    {
+        GLHelloWorld hw(shader.c_str(), resolutions[0].width, resolutions[0].height);
+        hw.setOffscreen(true);
+
+        for (auto &resolution : resolutions)
+        {
+            hw.resize(resolution.width, resolution.height);
+
+            // Warm up so that shader compilation in the driver is not part of the measurement
+            hw.drawFrame(0.0);
+            glFinish();
+
+            std::vector<double> frameTimes;
+            frameTimes.reserve(frames);
+            auto start = std::chrono::steady_clock::now();
+            auto previous = start;
+            for (int frame = 0; frame < frames; ++frame)
+            {
+                // Use a fixed time step so that the final image, and so the checksum, is reproducible
+                hw.drawFrame(frame / 60.0);
+                glFinish();
+
+                auto now = std::chrono::steady_clock::now();
+                frameTimes.push_back(std::chrono::duration<double, std::milli>(now - previous).count());
+                previous = now;
+            }
+            double total = std::chrono::duration<double>(previous - start).count();
+
+            std::sort(frameTimes.begin(), frameTimes.end());
+            char size[32];
+            snprintf(size, sizeof(size), "%dx%d", resolution.width, resolution.height);
+            printf("%-16s %11s %7d %9.1f %9.3f %9.3f %9.3f %9.3f  0x%08x\n", shader.c_str(), size, frames,
+                   (total > 0.0) ? frames / total : 0.0, percentile(frameTimes, 0.5), percentile(frameTimes, 0.9),
+                   percentile(frameTimes, 0.99), frameTimes.back(), hw.getPixelChecksum());
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
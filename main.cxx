@@ -2,15 +2,69 @@
 #include <fstream>
 #include <string>
 #include <string.h>
+#include <mutex>
 
-#include <GL/glew.h>
+#include "BzfGL.h"
 
 #include "PlatformFactory.h"
+#include "BzfBackend.h"
+#include "BzfFramePacer.h"
+#include "BzfJobSystem.h"
+#include "BzfMetrics.h"
+#include "BzfProfiler.h"
+#include "BzfRenderThread.h"
+#include "BzfTickScheduler.h"
 #include "GLHelloWorld.h"
+#include "GLDebugOutput.h"
+#include "GLMetricsOverlay.h"
+#include "GLResourceManager.h"
 #include "bzicon.h"
 
 #define MESSAGE_LEN 1024
 
+// Everything the event callbacks want to change about a window's rendering. The callbacks run on the main thread while
+// the window may be drawn from its own render thread, so changes are queued here and applied before the next frame.
+struct WindowState
+{
+    WindowState(GLHelloWorld *_hw, int _width, int _height) : hw(_hw), width(_width), height(_height) {}
+
+    void setPosition(double x, double y, double clickX, double clickY)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        position[0] = x;
+        position[1] = y;
+        position[2] = clickX;
+        position[3] = clickY;
+        positionChanged = true;
+    }
+
+    std::mutex mutex;
+    GLHelloWorld *hw;
+    // Paces the frames of this window, which is the platform's pacer unless the window has its own render thread
+    BzfFramePacer *pacer = nullptr;
+    // Drawable size in pixels, as of the window state version that was last looked at
+    int width, height;
+    unsigned long stateVersion = 0;
+    double position[4] = {0, 0, 0, 0};
+    bool positionChanged = false;
+    bool toggleDynamicResolution = false;
+    bool printStatistics = false;
+    bool toggleOverlay = false;
+    bool toggleLatency = false;
+    // Created on the render thread the first time it is shown
+    GLMetricsOverlay *overlay = nullptr;
+    bool showOverlay = false;
+    uint64_t lastFrameTicks = 0;
+    // The swap policy can only be set with the context current, so it is applied by the first frame as well
+    BzfSwapPolicy swapPolicy = BZF_SWAP_ON;
+    bool swapPolicyChanged = true;
+    // Frames the GPU may be behind, where 0 means no limit. Also applied by the first frame.
+    int framesInFlight = 2;
+    bool framesInFlightChanged = true;
+    // Frames drawn since the statistics were last printed
+    unsigned long frames = 0;
+};
+
 class MyCallbacks
 {
 public:
@@ -72,9 +126,72 @@ public:
                     printf("Input set to %s\n", useMouse?"mouse":"joystick");
                 }
                 else if (key == BZF_KEY_T)
+                {
                     printf("Current game time (in seconds): %f\n", platform->getGameTime());
+                    if (ticks != nullptr)
+                    {
+                        printf("Ticks: %lu run, %lu dropped, %.3f ms mean, %.3f ms deviation, %.3f ms max\n",
+                               ticks->getTickCount(), ticks->getDroppedTickCount(), ticks->getTickDurationMean() * 1000.0,
+                               ticks->getTickDurationStdDev() * 1000.0, ticks->getTickDurationMax() * 1000.0);
+                        ticks->resetStatistics();
+                    }
+                }
                 else if (key == BZF_KEY_F4)
                     window->iconify();
+                else if (key == BZF_KEY_R)
+                {
+                    auto windowState = static_cast<WindowState*>(window->getUserPointer());
+                    std::lock_guard<std::mutex> lock(windowState->mutex);
+                    windowState->toggleDynamicResolution = true;
+                }
+#ifdef BZF_PROFILING
+                else if (key == BZF_KEY_P)
+                {
+                    if (BzfProfiler::isCapturing())
+                    {
+                        BzfProfiler::stop();
+                        if (BzfProfiler::writeTrace("trace.json"))
+                            printf("Wrote trace.json (%lu events dropped)\n", BzfProfiler::getDroppedCount());
+                    }
+                    else
+                    {
+                        printf("Capturing a trace, press P again to save it\n");
+                        BzfProfiler::start();
+                    }
+                }
+#endif
+                else if (key == BZF_KEY_O)
+                {
+                    auto windowState = static_cast<WindowState*>(window->getUserPointer());
+                    std::lock_guard<std::mutex> lock(windowState->mutex);
+                    windowState->toggleOverlay = true;
+                }
+                else if (key == BZF_KEY_V)
+                {
+                    auto windowState = static_cast<WindowState*>(window->getUserPointer());
+                    std::lock_guard<std::mutex> lock(windowState->mutex);
+                    windowState->swapPolicy = (BzfSwapPolicy)((windowState->swapPolicy + 1) % (BZF_SWAP_HALF_RATE + 1));
+                    windowState->swapPolicyChanged = true;
+                }
+                else if (key == BZF_KEY_F)
+                {
+                    auto windowState = static_cast<WindowState*>(window->getUserPointer());
+                    std::lock_guard<std::mutex> lock(windowState->mutex);
+                    windowState->framesInFlight = (windowState->framesInFlight + 1) % (BzfFramesInFlight::maxLimit + 1);
+                    windowState->framesInFlightChanged = true;
+                }
+                else if (key == BZF_KEY_L)
+                {
+                    auto windowState = static_cast<WindowState*>(window->getUserPointer());
+                    std::lock_guard<std::mutex> lock(windowState->mutex);
+                    windowState->toggleLatency = true;
+                }
+                else if (key == BZF_KEY_U)
+                {
+                    auto windowState = static_cast<WindowState*>(window->getUserPointer());
+                    std::lock_guard<std::mutex> lock(windowState->mutex);
+                    windowState->printStatistics = true;
+                }
                 else if (key == BZF_KEY_G)
                 {
                     if (window->getGamma() < 1.0f)
@@ -103,17 +220,23 @@ public:
         return useMouse;
     }
 
+    void setTickScheduler(BzfTickScheduler* scheduler)
+    {
+        ticks = scheduler;
+    }
+
     void cursorPos(BzfPlatform* /*platform*/, BzfWindow* window, double x, double y)
     {
-        mouseX = x;
-        mouseY = y;
+        // The cursor is in screen coordinates, which are larger than pixels on HiDPI displays
+        int windowWidth, windowHeight, width, height;
+        window->getWindowSize(windowWidth, windowHeight);
+        window->getDrawableSize(width, height);
+        mouseX = windowWidth > 0 ? x * width / windowWidth : x;
+        mouseY = windowHeight > 0 ? y * height / windowHeight : y;
 
         if (leftMouseButtonDown && useMouse)
         {
-            int width, height;
-            window->getWindowSize(width, height);
-            window->makeContextCurrent();
-            static_cast<GLHelloWorld*>(window->getUserPointer())->setPosition(mouseX, height-mouseY, mouseClickX,
+            static_cast<WindowState*>(window->getUserPointer())->setPosition(mouseX, height-mouseY, mouseClickX,
                     height-mouseClickY);
         }
     }
@@ -133,11 +256,10 @@ public:
             else
             {
                 int width, height;
-                window->getWindowSize(width, height);
+                window->getDrawableSize(width, height);
                 double centerX = width / 2;
                 double centerY = height / 2;
-                window->makeContextCurrent();
-                static_cast<GLHelloWorld*>(window->getUserPointer())->setPosition(centerX, centerY, centerX, centerY);
+                static_cast<WindowState*>(window->getUserPointer())->setPosition(centerX, centerY, centerX, centerY);
             }
         }
     }
@@ -181,6 +303,7 @@ private:
     double mouseClickX = 0, mouseClickY = 0;
     bool useMouse = true;
     bool leftMouseButtonDown = false;
+    BzfTickScheduler* ticks = nullptr;
 };
 
 void scroll_callback(BzfPlatform* /*platform*/, BzfWindow* /*window*/, double x, double y)
@@ -188,16 +311,162 @@ void scroll_callback(BzfPlatform* /*platform*/, BzfWindow* /*window*/, double x,
     printf("Scroll position: %.1lf %.1lf\n", x, y);
 }
 
-void resize_callback(BzfPlatform* /*platform*/, BzfWindow* window, int width, int height)
+void resize_callback(BzfPlatform* /*platform*/, BzfWindow* /*window*/, int /*width*/, int /*height*/)
 {
-    window->makeContextCurrent();
-    static_cast<GLHelloWorld*>(window->getUserPointer())->resize(width, height);
+    // Nothing to do, render_window() picks up the new size through the window's state version. This runs for every
+    // step of a drag-resize, so it is no place for printing either.
+}
+
+// Draw one frame of a window, whose context has to be current on the calling thread
+void render_window(BzfPlatform* platform, BzfWindow* window)
+{
+    auto windowState = static_cast<WindowState*>(window->getUserPointer());
+    GLHelloWorld* hw = windowState->hw;
+
+    // Whatever input arrived until now is what this frame shows
+    BzfLatencyTracker& latency = window->getLatencyTracker();
+    latency.beginFrame();
+
+    {
+        std::lock_guard<std::mutex> lock(windowState->mutex);
+        // Only look at the window state again when it has changed
+        unsigned long stateVersion = window->getStateVersion();
+        if (stateVersion != windowState->stateVersion)
+        {
+            int width, height;
+            window->getDrawableSize(width, height);
+            if (width != windowState->width || height != windowState->height)
+            {
+                windowState->width = width;
+                windowState->height = height;
+                hw->resize(width, height);
+            }
+            windowState->stateVersion = stateVersion;
+        }
+        if (windowState->positionChanged)
+        {
+            hw->setPosition(windowState->position[0], windowState->position[1], windowState->position[2],
+                            windowState->position[3]);
+            windowState->positionChanged = false;
+        }
+        if (windowState->toggleDynamicResolution)
+        {
+            if (hw->isDynamicResolution())
+                hw->disableDynamicResolution();
+            else
+                hw->enableDynamicResolution(1.0 / 60.0);
+            printf("Dynamic resolution %s\n", hw->isDynamicResolution()?"enabled":"disabled");
+            windowState->toggleDynamicResolution = false;
+        }
+        if (windowState->toggleOverlay)
+        {
+            windowState->showOverlay = !windowState->showOverlay;
+            if (windowState->showOverlay && windowState->overlay == nullptr)
+                windowState->overlay = new GLMetricsOverlay(hw->getStateCache());
+            windowState->toggleOverlay = false;
+        }
+        if (windowState->framesInFlightChanged)
+        {
+            window->getFramesInFlight().setLimit(windowState->framesInFlight);
+            if (windowState->framesInFlight == 0)
+                printf("Frames in flight for %p: unlimited\n", static_cast<void*>(window));
+            else
+                printf("Frames in flight for %p: at most %d\n", static_cast<void*>(window), windowState->framesInFlight);
+            windowState->framesInFlightChanged = false;
+        }
+        if (windowState->toggleLatency)
+        {
+            latency.setEnabled(!latency.isEnabled());
+            latency.resetLatencies();
+            printf("Input latency measurement for %p %s\n", static_cast<void*>(window),
+                   latency.isEnabled()?"enabled":"disabled");
+            windowState->toggleLatency = false;
+        }
+        if (windowState->swapPolicyChanged)
+        {
+            static const char* swapPolicyNames[] = { "off", "on", "adaptive", "half rate" };
+            BzfSwapPolicy granted = window->setSwapPolicy(windowState->swapPolicy);
+            printf("Swap policy for %p: %s requested, %s granted\n", static_cast<void*>(window),
+                   swapPolicyNames[windowState->swapPolicy], swapPolicyNames[granted]);
+            windowState->swapPolicy = granted;
+            windowState->swapPolicyChanged = false;
+        }
+        if (windowState->printStatistics)
+        {
+            auto &uniforms = hw->getUniformCache();
+            auto &state = hw->getStateCache();
+            printf("Uniform updates for %p: %lu issued, %lu skipped\n", static_cast<void*>(window),
+                   uniforms.getIssuedCount(), uniforms.getSkippedCount());
+            printf("State changes for %p: %lu issued, %lu skipped\n", static_cast<void*>(window),
+                   state.getIssuedCount(), state.getSkippedCount());
+            printf("Context switches for %p: %lu over %lu frames\n", static_cast<void*>(window),
+                   window->getContextSwitchCount(), windowState->frames);
+            BzfFramePacer* pacer = windowState->pacer;
+            printf("Frame times for %p: %.2f ms mean, %.2f ms deviation, %.2f ms min, %.2f ms max\n",
+                   static_cast<void*>(window), pacer->getFrameTimeMean() * 1000.0, pacer->getFrameTimeStdDev() * 1000.0,
+                   pacer->getFrameTimeMin() * 1000.0, pacer->getFrameTimeMax() * 1000.0);
+            pacer->resetStatistics();
+            const BzfSwapHistogram& swaps = window->getSwapHistogram();
+            printf("Swap intervals for %p: %.2f ms mean, %.0f ms median, %.0f ms 99th percentile, %d of %d missed\n",
+                   static_cast<void*>(window), swaps.getMean() * 1000.0, swaps.getPercentile(0.5) * 1000.0,
+                   swaps.getPercentile(0.99) * 1000.0, swaps.getMissedCount(window->getSwapDeadline()),
+                   swaps.getCount());
+            BzfFramesInFlight& framesInFlight = window->getFramesInFlight();
+            if (framesInFlight.getLimit() > 0)
+                printf("GPU waits for %p: %.2f ms mean, %.2f ms max over %lu frames\n", static_cast<void*>(window),
+                       framesInFlight.getWaitMean() * 1000.0, framesInFlight.getWaitMax() * 1000.0,
+                       framesInFlight.getFrameCount());
+            framesInFlight.resetStatistics();
+            if (latency.isEnabled())
+            {
+                const BzfHistogram& latencies = latency.getLatencies();
+                printf("Input latency for %p: %.2f ms mean, %.0f ms median, %.0f ms 99th percentile over %llu frames\n",
+                       static_cast<void*>(window), latencies.getMean(), latencies.getPercentile(0.5),
+                       latencies.getPercentile(0.99), (unsigned long long)latencies.getCount());
+                latency.resetLatencies();
+            }
+            window->resetContextSwitchCount();
+            windowState->frames = 0;
+            windowState->printStatistics = false;
+        }
+        ++windowState->frames;
+    }
+
+    hw->drawFrame(platform->getGameTime());
+
+    uint64_t now = platform->getGameTicks();
+    double frameTime = windowState->lastFrameTicks != 0 ? BzfClock::toSeconds(now - windowState->lastFrameTicks) : 0.0;
+    windowState->lastFrameTicks = now;
+
+    if (windowState->showOverlay)
+    {
+        static BzfCounter* events = BzfMetrics::get().counter("events");
+        static BzfCounter* underruns = BzfMetrics::get().counter("audio.underruns");
+        const BzfSwapHistogram& swaps = window->getSwapHistogram();
+
+        // Frame time in ms, frames per second, events so far, recently missed swaps, audio underruns so far and the
+        // mean input latency in ms (when it is measured)
+        GLMetricsOverlay* overlay = windowState->overlay;
+        overlay->setBudget(window->getSwapDeadline());
+        overlay->addFrameTime(frameTime);
+        overlay->setLine(0, frameTime * 1000.0, 2);
+        overlay->setLine(1, frameTime > 0.0 ? 1.0 / frameTime : 0.0);
+        overlay->setLine(2, (double)events->get());
+        overlay->setLine(3, swaps.getMissedCount(window->getSwapDeadline()));
+        overlay->setLine(4, (double)underruns->get());
+        if (latency.isEnabled())
+            overlay->setLine(5, latency.getLatencies().getMean(), 1);
+        overlay->draw(windowState->width, windowState->height);
+    }
 }
 
 int main()
 {
-    // Get the platform factory
-    BzfPlatform* platform = PlatformFactory::get();
+    BZF_PROFILE_THREAD("main");
+
+    // Create the platform, which is deleted at the end. The main loop goes through the backend types, so that with
+    // static dispatch its calls into the platform can be inlined.
+    BzfBackendPlatform* platform = bzfBackend(PlatformFactory::create());
 
     BzfAudio* audio = platform->getAudio();
     if (audio != nullptr)
@@ -208,7 +477,7 @@ int main()
             printf(" * %s\n", audioDevice);
     }
 
-    BzfJoystick* joystick = platform->getJoystick();
+    BzfBackendJoystick* joystick = bzfBackend(platform->getJoystick());
     if (joystick != nullptr)
     {
         auto joysticks = joystick->getJoysticks();
@@ -231,6 +500,13 @@ int main()
 #endif
     // Request 8 bits per channel
     platform->GLSetRGBA(8, 8, 8, 8);
+    // Have the driver check everything and report what it finds while developing, and skip its checks in release builds
+#ifdef NDEBUG
+    bool debugContexts = false;
+#else
+    bool debugContexts = true;
+#endif
+    platform->GLSetContextFlags(debugContexts ? BZF_GL_CONTEXT_DEBUG : BZF_GL_CONTEXT_NO_ERROR);
 
     // Get all monitors
     auto monitors = platform->getMonitors();
@@ -250,6 +526,29 @@ int main()
 
     // Windowed mode
     bool windowed = true;
+    // Render each window from its own thread, so that a swap waiting for vertical sync does not hold up the others
+    bool threadedRendering = true;
+    // Frames per second to draw each window at, or 0 to only be limited by vertical sync
+    double frameRateLimit = 120.0;
+    // Build the programs once for all windows. Their uniforms are shared along with them, so render threads take turns
+    // at drawing a program, see GLResourceManager.
+    bool sharedContexts = true;
+    platform->GLSetSharedContexts(sharedContexts);
+    GLResourceManager* resources = sharedContexts ? new GLResourceManager : nullptr;
+
+    // Read the shaders on the job system while the windows and their contexts are being made. Compiling them has to
+    // wait for the contexts, so that is left to GLHelloWorld.
+    BzfJobSystem* jobs = platform->getJobSystem();
+    char* shaderSources[2] = { nullptr, nullptr };
+    BzfJobHandle shaderReads[2];
+    shaderReads[0] = jobs->submit([&shaderSources]()
+    {
+        shaderSources[0] = GLHelloWorld::readShader("Mss3WN.frag");
+    });
+    shaderReads[1] = jobs->submit([&shaderSources]()
+    {
+        shaderSources[1] = GLHelloWorld::readShader("ldfGWn.frag");
+    });
 
     // Create a window on each monitor at the current desktop resolution
     std::vector<BzfWindow*> windows;
@@ -265,14 +564,28 @@ int main()
             window = platform->createWindow(resolution, monitors.at(0));
         }
         window->setMinSize(512, 384);
+        window->setAutoAdaptiveSync(true);
         window->setTitle("Mss3WN");
         window->setIcon(&icon);
 
         // From: https://www.shadertoy.com/view/Mss3WN
         window->makeContextCurrent();
         int width, height;
-        window->getWindowSize(width, height);
-        window->setUserPointer(new GLHelloWorld("Mss3WN.frag", width, height));
+        window->getDrawableSize(width, height);
+        jobs->wait(shaderReads[0]);
+        if (shaderSources[0] == nullptr)
+        {
+            // Exiting from the job would run the static destructors under the feet of the main thread
+            printf("Unable to read the shader Mss3WN.frag\n");
+            exit(-10);
+        }
+        window->setUserPointer(new WindowState(new GLHelloWorld("Mss3WN.frag", width, height, resources,
+                                               shaderSources[0]), width, height));
+        if (debugContexts && !GLDebugOutput::enable(window->getGLCapabilities()))
+            printf("No debug output for %s\n", "Mss3WN");
+        // Only a hint, and not part of desktop OpenGL before 4.1
+        if (window->getGLCapabilities().releaseShaderCompiler)
+            glReleaseShaderCompiler();
 
         windows.push_back(window);
     }
@@ -288,17 +601,50 @@ int main()
             window = platform->createWindow(resolution, monitors.at(1));
         }
         window->setMinSize(640, 480);
+        window->setAutoAdaptiveSync(true);
         window->setTitle("ldfGWn");
 
         // From: https://www.shadertoy.com/view/ldfGWn
         window->makeContextCurrent();
         int width, height;
-        window->getWindowSize(width, height);
-        window->setUserPointer(new GLHelloWorld("ldfGWn.frag", width, height));
+        window->getDrawableSize(width, height);
+        jobs->wait(shaderReads[1]);
+        if (shaderSources[1] == nullptr)
+        {
+            // Exiting from the job would run the static destructors under the feet of the main thread
+            printf("Unable to read the shader ldfGWn.frag\n");
+            exit(-10);
+        }
+        window->setUserPointer(new WindowState(new GLHelloWorld("ldfGWn.frag", width, height, resources,
+                                               shaderSources[1]), width, height));
+        if (debugContexts && !GLDebugOutput::enable(window->getGLCapabilities()))
+            printf("No debug output for %s\n", "ldfGWn");
+        // Only a hint, and not part of desktop OpenGL before 4.1
+        if (window->getGLCapabilities().releaseShaderCompiler)
+            glReleaseShaderCompiler();
 
         windows.push_back(window);
     }
 
+    // The programs are built, and the sources are read even for windows that were not made
+    for (int i = 0; i < 2; i++)
+    {
+        jobs->wait(shaderReads[i]);
+        free(shaderSources[i]);
+    }
+
+    for (auto window : windows)
+    {
+        const BzfGLCapabilities &capabilities = window->getGLCapabilities();
+        printf("Context of %p: OpenGL%s %d.%d, sync %s, debug output %s\n", static_cast<void*>(window),
+               capabilities.es?" ES":"", capabilities.majorVersion, capabilities.minorVersion,
+               capabilities.sync?"yes":"no", capabilities.debugOutput?"yes":"no");
+    }
+
+    if (resources != nullptr)
+        printf("Programs: %lu built, %lu reused from another window\n", resources->getBuildCount(),
+               resources->getReuseCount());
+
     // Callbacks
     using namespace std::placeholders;
     MyCallbacks *callbacks = new MyCallbacks;
@@ -314,39 +660,108 @@ int main()
     platform->setScrollCallback(scroll_callback);
     platform->addResizeCallback(resize_callback);
 
-    while (platform->isGameRunning())
+    BzfFramePacer* framePacer = platform->getFramePacer();
+    std::vector<BzfRenderThread*> renderThreads;
+    if (threadedRendering)
     {
-        platform->pollEvents();
+        for (auto &window : windows)
+        {
+            WindowState* windowState = static_cast<WindowState*>(window->getUserPointer());
+            windowState->pacer = new BzfFramePacer(platform);
+            windowState->pacer->setTargetFrameRate(frameRateLimit);
+
+            // The context was left current on this thread when the window was set up
+            window->releaseContext();
+            BzfRenderThread* renderThread = new BzfRenderThread(window, [platform](BzfWindow* renderWindow)
+            {
+                static_cast<WindowState*>(renderWindow->getUserPointer())->pacer->beginFrame();
+                render_window(platform, renderWindow);
+            });
+            renderThread->start();
+            renderThreads.push_back(renderThread);
+        }
 
+        // The render threads pace themselves, so the main thread only has to wake up for events and the ticks below
+        framePacer->setTargetFrameRate(frameRateLimit);
+        framePacer->setEventWaiting(true);
+    }
+    else
+    {
         for (auto &window : windows)
+            static_cast<WindowState*>(window->getUserPointer())->pacer = framePacer;
+
+        // Poll the input right before drawing rather than before waiting for the frame to be due
+        framePacer->setTargetFrameRate(frameRateLimit);
+        framePacer->setLateInputPolling(true);
+    }
+
+    // The joystick stands in for game logic here, and is sampled at a fixed rate no matter how fast the windows draw
+    BzfTickScheduler scheduler(platform, 60.0);
+    callbacks->setTickScheduler(&scheduler);
+
+    // While every window is minimized, wake up ten times a second at most instead of drawing
+    platform->setIdleInterval(0.1);
+
+    // Keep a record of the metrics for looking at later
+    BzfMetrics::get().setPeriodicDump("metrics.csv", 10.0);
+
+    while (platform->isGameRunning())
+    {
+        framePacer->beginFrame();
+        BzfMetrics::get().dumpIfDue(platform->getGameTime());
+
+        scheduler.update([&](unsigned long /*tick*/, double /*interval*/)
         {
-            window->makeContextCurrent();
-            auto hw = static_cast<GLHelloWorld*>(window->getUserPointer());
-            if (!callbacks->usingMouse())
+            if (callbacks->usingMouse())
+                return;
+
+            for (auto &window : windows)
             {
                 int width, height;
-                window->getWindowSize(width, height);
+                window->getDrawableSize(width, height);
                 double centerX = width / 2;
                 double centerY = height / 2;
                 double scaleX = 1 / centerX;
                 double scaleY = 1 / centerY;
 
-                hw->setPosition(centerX + (joystick->getAxis(0) / scaleX), centerY - (joystick->getAxis(1) / scaleY), centerX, centerY);
+                static_cast<WindowState*>(window->getUserPointer())->setPosition(
+                    centerX + (joystick->getAxis(0) / scaleX), centerY - (joystick->getAxis(1) / scaleY), centerX, centerY);
+            }
+        });
+
+        for (auto &window : windows)
+        {
+            if (!threadedRendering && !window->isHidden())
+            {
+                BzfBackendWindow* backendWindow = bzfBackend(window);
+                backendWindow->makeContextCurrent();
+                render_window(platform, window);
+                backendWindow->swapBuffers();
             }
-            hw->drawFrame(platform->getGameTime());
-            window->swapBuffers();
         }
     }
 
+    // Stop the render threads, which gives their contexts back to this thread
+    for (auto &renderThread : renderThreads)
+        delete renderThread;
+    renderThreads.clear();
+
     // Delete test programs
     for (auto &window : windows)
     {
-        GLHelloWorld* hw = static_cast<GLHelloWorld*>(window->getUserPointer());
-        delete hw;
+        window->makeContextCurrent();
+        WindowState* windowState = static_cast<WindowState*>(window->getUserPointer());
+        delete windowState->overlay;
+        delete windowState->hw;
+        if (threadedRendering)
+            delete windowState->pacer;
+        delete windowState;
         window->setUserPointer(nullptr);
     }
+    // The last window's context is still current, which shares the objects of all of them
+    delete resources;
 
-    // Delete platform factory
+    // Delete the platform
     delete platform;
     platform = nullptr;
 